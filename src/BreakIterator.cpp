@@ -0,0 +1,158 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+/* ------------- Implementation for BreakIterator.h ---------------- */
+
+#include "BreakIterator.h"
+#include "Hyphenator.h"
+#include <algorithm>
+#include <pthread.h>
+
+using namespace std;
+using namespace Hyphenate;
+
+/* The characters that start a word. The set is made on first use and
+ * shared by all iterators; it is never released. */
+static CFCharacterSetRef non_whitespace_set() {
+   static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+   static CFCharacterSetRef set = NULL;
+
+   pthread_mutex_lock(&lock);
+   if (!set)
+      set = CFCharacterSetCreateInvertedSet(kCFAllocatorDefault,
+         CFCharacterSetGetPredefined(kCFCharacterSetWhitespaceAndNewline));
+   pthread_mutex_unlock(&lock);
+   return set;
+}
+
+Hyphenate::BreakIterator::BreakIterator(const Hyphenator &h, CFStringRef t)
+: hyphenator(h), text(t)
+{
+   text_length = CFStringGetLength(text);
+   whitespace = CFCharacterSetGetPredefined(kCFCharacterSetWhitespaceAndNewline);
+   non_whitespace = non_whitespace_set();
+   punctuation = CFCharacterSetGetPredefined(kCFCharacterSetPunctuation);
+   end = text_length;
+   word_start = word_length = next_letter = 0;
+   seek(0);
+}
+
+Hyphenate::BreakIterator::BreakIterator(const Hyphenator &h, CFStringRef t,
+   CFRange range)
+: hyphenator(h), text(t)
+{
+   text_length = CFStringGetLength(text);
+   whitespace = CFCharacterSetGetPredefined(kCFCharacterSetWhitespaceAndNewline);
+   non_whitespace = non_whitespace_set();
+   punctuation = CFCharacterSetGetPredefined(kCFCharacterSetPunctuation);
+   end = max((CFIndex)0, min(text_length, range.location + range.length));
+   word_start = word_length = next_letter = 0;
+   seek(max((CFIndex)0, range.location));
+}
+
+Hyphenate::BreakIterator::~BreakIterator() {}
+
+CFIndex Hyphenate::BreakIterator::start_of_word(CFIndex index) const {
+   if (index <= 0 || index >= text_length)
+      return index;
+   CFRange found;
+   if (!CFStringFindCharacterFromSet(text, whitespace,
+         CFRangeMake(0, index), kCFCompareBackwards, &found))
+      return 0;
+   return found.location + 1;
+}
+
+void Hyphenate::BreakIterator::seek(CFIndex position) {
+   first_position = position;
+   if (position >= word_start && position < word_start + word_length) {
+      /* Still within the word at hand; no need to hyphenate it again. */
+      next_letter = position - word_start;
+      return;
+   }
+   scan = start_of_word(position);
+   word_length = next_letter = 0;
+}
+
+bool Hyphenate::BreakIterator::next_word() {
+   for (;;) {
+      CFRange found;
+      if (scan >= end || !CFStringFindCharacterFromSet(text, non_whitespace,
+            CFRangeMake(scan, end - scan), 0, &found)) {
+         scan = end;
+         word_length = next_letter = 0;
+         return false;
+      }
+      CFIndex start = found.location, stop = text_length;
+      if (CFStringFindCharacterFromSet(text, whitespace,
+            CFRangeMake(start, text_length - start), 0, &found))
+         stop = found.location;
+      scan = stop;
+      if (stop <= first_position)
+         continue;
+
+      CFIndex length = stop - start;
+      if ((CFIndex)characters.size() < length) {
+         characters.resize(length);
+         rules.resize(length);
+         priorities.resize(length);
+      }
+      CFStringGetCharacters(text, CFRangeMake(start, length),
+         &characters[0]);
+
+      /* Leave out the punctuation around the word. */
+      CFIndex first = 0, last = length;
+      while (first < last &&
+            CFCharacterSetIsCharacterMember(punctuation, characters[first]))
+         first++;
+      while (last > first &&
+            CFCharacterSetIsCharacterMember(punctuation, characters[last - 1]))
+         last--;
+      if (first == last || start + last <= first_position)
+         continue;
+
+      word_start = start + first;
+      word_length = last - first;
+      next_letter = max((CFIndex)0, first_position - word_start);
+      hyphenator.applyHyphenationRules(&characters[first], word_length,
+         &rules[0], &priorities[0]);
+      return true;
+   }
+}
+
+bool Hyphenate::BreakIterator::next(Break &point) {
+   for (;;) {
+      /* Positions at or past the end of the range are not reported, but
+       * the word is hyphenated as a whole. */
+      CFIndex letters = min(word_length, end - word_start);
+      while (next_letter < letters) {
+         CFIndex i = next_letter++;
+         if (!rules[i])
+            continue;
+         point.position = word_start + i;
+         point.priority = priorities[i];
+         point.rule = rules[i];
+         return true;
+      }
+      if (!next_word())
+         return false;
+   }
+}
@@ -0,0 +1,114 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+#ifndef HYPHENATE_BREAK_ITERATOR_H
+#define HYPHENATE_BREAK_ITERATOR_H
+
+#include <vector>
+#include <CoreFoundation/CoreFoundation.h>
+
+namespace Hyphenate {
+   class Hyphenator;
+   class HyphenationRule;
+
+   /** A BreakIterator walks through the hyphenation points of a text, one
+    *  at a time, as the caller asks for them. The text is cut into words
+    *  at whitespace, and each word is hyphenated only once the iterator
+    *  reaches it, so a caller that needs just the first few breaks, like
+    *  a line breaker filling one line, pays only for the words it looks
+    *  at, and may stop at any time.
+    *
+    *  Punctuation at the start and end of a word, like quotes, brackets
+    *  and commas, is not part of the word, so "(Schiffahrt)," has the
+    *  same hyphenation points as Hyphenator::applyHyphenationRules gives
+    *  Schiffahrt. Punctuation within a word is kept, and the patterns'
+    *  safe areas apply around it as usual.
+    *
+    *  The Hyphenator and the text must outlive the iterator. */
+   class BreakIterator {
+      public:
+         /** A hyphenation point. */
+         struct Break {
+            /** The index in the text of the letter the hyphen goes before. */
+            CFIndex position;
+            /** The priority of the pattern that allowed the hyphen, an odd
+             *  number from 1 up. */
+            int priority;
+            /** The rule to apply; a non-standard rule changes the letters
+             *  around the hyphen (see README.nonstandard). */
+            const HyphenationRule *rule;
+         };
+
+      private:
+         const Hyphenator &hyphenator;
+         CFStringRef text;
+         CFIndex text_length, end;
+         CFCharacterSetRef whitespace, non_whitespace, punctuation;
+
+         /* Where to look for the next word, and the first position that
+          * may be reported. */
+         CFIndex scan, first_position;
+
+         /* The word last hyphenated, and the index in it of the next
+          * letter to look at. */
+         CFIndex word_start, word_length, next_letter;
+         std::vector<UniChar> characters;
+         std::vector<const HyphenationRule*> rules;
+         std::vector<UInt8> priorities;
+
+         /* The start of the word around the given index, or the index
+          * itself if it is not within a word. */
+         CFIndex start_of_word(CFIndex index) const;
+
+         /* Hyphenate the next word that reaches up to first_position.
+          * Returns false at the end of the range. */
+         bool next_word();
+
+         BreakIterator(const BreakIterator &);
+         BreakIterator &operator=(const BreakIterator &);
+
+      public:
+         /** Iterate over the hyphenation points of the whole text. */
+         BreakIterator(const Hyphenator &hyphenator, CFStringRef text);
+
+         /** Iterate over the hyphenation points within the given range of
+          *  the text. Words crossing the edges of the range are hyphenated
+          *  as a whole, but only their points within the range are
+          *  reported. */
+         BreakIterator(const Hyphenator &hyphenator, CFStringRef text,
+            CFRange range);
+
+         ~BreakIterator();
+
+         /** Store the next hyphenation point in the given Break. Returns
+          *  false if there are no more. */
+         bool next(Break &point);
+
+         /** Continue with the hyphenation points at or after the given
+          *  index in the text, which may lie before or after the ones
+          *  returned so far. Words that end before it are skipped without
+          *  being hyphenated. */
+         void seek(CFIndex position);
+   };
+}
+
+#endif
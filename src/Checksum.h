@@ -0,0 +1,48 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+#ifndef HYPHENATE_CHECKSUM_H
+#define HYPHENATE_CHECKSUM_H
+
+#include <stddef.h>
+#include <CoreFoundation/CoreFoundation.h>
+
+namespace Hyphenate {
+   /** The initial value for checksum(). */
+   const UInt64 checksum_seed = 14695981039346656037ULL;
+
+   /** Compute the 64 bit FNV-1a hash of the given bytes, which identifies
+    *  the contents of a pattern file. To checksum data that arrives in
+    *  pieces, pass the result for the previous piece as seed. */
+   inline UInt64 checksum(const void *data, size_t length,
+      UInt64 seed = checksum_seed)
+   {
+      const unsigned char *bytes = (const unsigned char *)data;
+      for (size_t i = 0; i < length; i++) {
+         seed ^= bytes[i];
+         seed *= 1099511628211ULL;
+      }
+      return seed;
+   }
+}
+
+#endif
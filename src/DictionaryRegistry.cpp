@@ -0,0 +1,296 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+/* ------------- Implementation for DictionaryRegistry.h ---------------- */
+
+#include "DictionaryRegistry.h"
+#include "Checksum.h"
+#include "HyphenationTree.h"
+#include "NodeProfile.h"
+#include "NumaNodes.h"
+#include "OverlayDictionary.h"
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <stdlib.h>
+
+using namespace std;
+using namespace Hyphenate;
+
+/* A dictionary that has been or is being loaded, with one copy per node.
+ * users counts the threads that have claimed the slot and not yet seen
+ * the outcome of the load; a slot whose load failed is deleted by the
+ * last of them. */
+struct Hyphenate::RegistrySlot {
+   vector<HyphenationTree*> trees;
+   vector<OverlayDictionary*> dialects;
+   bool done;
+   string error;
+   size_t users;
+
+   RegistrySlot() : done(false), users(0) {}
+
+   ~RegistrySlot() {
+      for (size_t n = 0; n < dialects.size(); n++)
+         delete dialects[n];
+      for (size_t n = 0; n < trees.size(); n++)
+         delete trees[n];
+   }
+};
+
+/* Loads the copies of a dictionary into a slot, each on its own node. A
+ * dialect is loaded over the copy of its base for the same node. */
+class RegistryLoad : public NumaNodes::Job {
+   public:
+      RegistryLoad(RegistrySlot *slot, const string &path, size_t copies,
+         bool flat, const vector<HyphenationTree*> *bases)
+      : slot(slot), path(path), flat(flat), bases(bases), errors(copies)
+      {
+         if (bases)
+            slot->dialects.assign(copies, (OverlayDictionary*)NULL);
+         else
+            slot->trees.assign(copies, (HyphenationTree*)NULL);
+      }
+
+      void run(size_t node) {
+         try {
+            if (bases) {
+               ifstream i(path.c_str(), fstream::in);
+               if (!i)
+                  throw domain_error("libhyphenate-cfstring: Cannot read "
+                     "pattern file " + path);
+               auto_ptr<OverlayDictionary> d(
+                  new OverlayDictionary(*(*bases)[node]));
+               d->loadPatterns(i);
+               slot->dialects[node] = d.release();
+               return;
+            }
+
+            auto_ptr<HyphenationTree> t(new HyphenationTree());
+            t->loadPatterns(path.c_str());
+            /* Without a profile for these patterns, the nodes stay
+             * wherever they were allocated; move them into a block of
+             * their own. */
+            if (flat && !t->isLaidOut())
+               t->optimizeLayout(NodeProfile());
+            slot->trees[node] = t.release();
+         } catch (const exception &e) {
+            errors[node] = e.what();
+         }
+      }
+
+      /* Keep the copies if all of them loaded, or note the error. */
+      void finish() {
+         for (size_t n = 0; n < errors.size(); n++) {
+            if (errors[n].empty())
+               continue;
+            slot->error = errors[n];
+            for (size_t c = 0; c < slot->dialects.size(); c++)
+               delete slot->dialects[c];
+            for (size_t c = 0; c < slot->trees.size(); c++)
+               delete slot->trees[c];
+            slot->dialects.clear();
+            slot->trees.clear();
+            return;
+         }
+      }
+
+   private:
+      RegistrySlot *slot;
+      /* A copy, as the job runs on other threads. */
+      string path;
+      bool flat;
+      const vector<HyphenationTree*> *bases;
+      vector<string> errors;
+};
+
+Hyphenate::DictionaryRegistry::DictionaryRegistry()
+: numa_nodes(NULL)
+{
+   pthread_mutex_init(&lock, NULL);
+   pthread_cond_init(&loaded, NULL);
+}
+
+Hyphenate::DictionaryRegistry::DictionaryRegistry(const NumaNodes &nodes)
+: numa_nodes(&nodes)
+{
+   pthread_mutex_init(&lock, NULL);
+   pthread_cond_init(&loaded, NULL);
+}
+
+Hyphenate::DictionaryRegistry::~DictionaryRegistry() {
+   /* Dialects refer to their base trees, so they go first. */
+   for (SlotMap::iterator i = dialects.begin(); i != dialects.end(); i++)
+      delete i->second;
+   for (SlotMap::iterator i = trees.begin(); i != trees.end(); i++)
+      delete i->second;
+   pthread_cond_destroy(&loaded);
+   pthread_mutex_destroy(&lock);
+}
+
+DictionaryRegistry &Hyphenate::DictionaryRegistry::standard() {
+   /* Never deleted, so that Hyphenators may outlive static destruction. */
+   static pthread_mutex_t standard_lock = PTHREAD_MUTEX_INITIALIZER;
+   static DictionaryRegistry *registry = NULL;
+
+   pthread_mutex_lock(&standard_lock);
+   if (!registry) {
+      /* Replicate where there is more than one node, unless told
+       * otherwise. */
+      const char *replicate = getenv("LIBHYPHENATE_REPLICATE");
+      bool per_node = (replicate && *replicate)
+         ? string(replicate) != "0"
+         : NumaNodes::system().count() > 1;
+      registry = per_node
+         ? new DictionaryRegistry(NumaNodes::system())
+         : new DictionaryRegistry();
+   }
+   pthread_mutex_unlock(&standard_lock);
+   return *registry;
+}
+
+size_t Hyphenate::DictionaryRegistry::copies() const {
+   return numa_nodes ? numa_nodes->count() : 1;
+}
+
+void Hyphenate::DictionaryRegistry::check_node(size_t node) const {
+   if (node >= copies())
+      throw domain_error("libhyphenate-cfstring: No copy of the "
+         "dictionaries for this node");
+}
+
+/* Find the slot for key. Returns true if it is new, in which case the
+ * caller must load it and call finish. */
+bool Hyphenate::DictionaryRegistry::claim(SlotMap &slots, const Key &key,
+   RegistrySlot *&slot)
+{
+   pthread_mutex_lock(&lock);
+   SlotMap::iterator i = slots.find(key);
+   bool fresh = (i == slots.end());
+   if (fresh)
+      i = slots.insert(make_pair(key, new RegistrySlot())).first;
+   slot = i->second;
+   slot->users++;
+   pthread_mutex_unlock(&lock);
+   return fresh;
+}
+
+/* Mark the slot as loaded. If the load failed, the slot leaves the map, so
+ * that the next claim for the key tries again. */
+void Hyphenate::DictionaryRegistry::finish(SlotMap &slots, const Key &key,
+   RegistrySlot *slot)
+{
+   pthread_mutex_lock(&lock);
+   slot->done = true;
+   if (slot->trees.empty() && slot->dialects.empty())
+      slots.erase(key);
+   pthread_cond_broadcast(&loaded);
+   pthread_mutex_unlock(&lock);
+}
+
+void Hyphenate::DictionaryRegistry::wait(RegistrySlot *slot) {
+   pthread_mutex_lock(&lock);
+   while (!slot->done)
+      pthread_cond_wait(&loaded, &lock);
+   slot->users--;
+   if (!slot->trees.empty() || !slot->dialects.empty()) {
+      pthread_mutex_unlock(&lock);
+      return;
+   }
+
+   string error = slot->error;
+   if (slot->users == 0)
+      delete slot;
+   pthread_mutex_unlock(&lock);
+   throw domain_error(error);
+}
+
+const vector<HyphenationTree*> &Hyphenate::DictionaryRegistry::trees_for(
+   const PatternCatalog::Entry &entry)
+{
+   if (!entry.base.empty())
+      throw domain_error("libhyphenate-cfstring: " + entry.tag + " is a "
+         "dialect of " + entry.base + ", not a pattern file");
+
+   Key key(entry.checksum(), entry.size);
+   RegistrySlot *slot;
+   if (claim(trees, key, slot)) {
+      RegistryLoad load(slot, entry.path, copies(), numa_nodes != NULL,
+         NULL);
+      if (numa_nodes)
+         numa_nodes->runOnEach(load);
+      else
+         load.run(0);
+      load.finish();
+      finish(trees, key, slot);
+   }
+
+   wait(slot);
+   return slot->trees;
+}
+
+const HyphenationTree &Hyphenate::DictionaryRegistry::tree(
+   const PatternCatalog::Entry &entry, size_t node)
+{
+   check_node(node);
+   return *trees_for(entry)[node];
+}
+
+const OverlayDictionary &Hyphenate::DictionaryRegistry::dialect(
+   const PatternCatalog &catalog, const PatternCatalog::Entry &entry,
+   size_t node)
+{
+   check_node(node);
+   if (entry.base.empty())
+      throw domain_error("libhyphenate-cfstring: " + entry.tag + " is not "
+         "a dialect");
+   const PatternCatalog::Entry *base = catalog.find(entry.base);
+   if (!base)
+      throw domain_error("libhyphenate-cfstring: Base " + entry.base +
+         " of " + entry.tag + " not found in " + catalog.directory());
+   const vector<HyphenationTree*> &base_trees = trees_for(*base);
+
+   /* The same differences to another base make another dialect. */
+   UInt64 base_checksum = base->checksum();
+   Key key(checksum(&base_checksum, sizeof(base_checksum), entry.checksum()),
+      entry.size + base->size);
+   RegistrySlot *slot;
+   if (claim(dialects, key, slot)) {
+      RegistryLoad load(slot, entry.path, copies(), false, &base_trees);
+      if (numa_nodes)
+         numa_nodes->runOnEach(load);
+      else
+         load.run(0);
+      load.finish();
+      finish(dialects, key, slot);
+   }
+
+   wait(slot);
+   return *slot->dialects[node];
+}
+
+size_t Hyphenate::DictionaryRegistry::size() const {
+   pthread_mutex_lock(&lock);
+   size_t n = trees.size() + dialects.size();
+   pthread_mutex_unlock(&lock);
+   return n;
+}
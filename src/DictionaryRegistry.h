@@ -0,0 +1,125 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+#ifndef HYPHENATE_DICTIONARY_REGISTRY_H
+#define HYPHENATE_DICTIONARY_REGISTRY_H
+
+#include "PatternCatalog.h"
+#include <map>
+#include <utility>
+#include <vector>
+#include <pthread.h>
+
+namespace Hyphenate {
+   class HyphenationTree;
+   class NumaNodes;
+   class OverlayDictionary;
+   struct RegistrySlot;
+
+   /** The DictionaryRegistry loads each dictionary once, no matter how many
+    *  language tags lead to it. Pattern files are identified by their
+    *  contents (the checksum and size in their PatternCatalog::Entry), so
+    *  that identical files under different names share one tree.
+    *
+    *  A catalog entry with a base is a dialect: its file holds only the
+    *  differences to the base's patterns, and it is loaded as an
+    *  OverlayDictionary over the base's shared tree. A pattern in the file
+    *  adds to or replaces the base's pattern for the same letters, and a
+    *  pattern without digits removes it.
+    *
+    *  On machines with several NUMA nodes, a registry may keep a copy of
+    *  each dictionary in the memory of each node, so that threads do not
+    *  read the trees across the interconnect. Hyphenator picks the copy
+    *  for the node its calling thread runs on.
+    *
+    *  The registry may be used from several threads; different
+    *  dictionaries are loaded in parallel. */
+   class DictionaryRegistry {
+      public:
+         DictionaryRegistry();
+
+         /** A registry that loads each dictionary once for each of the
+          *  given nodes, on a thread running on that node, and lays out
+          *  the nodes of each copy's tree in one block of memory (see
+          *  HyphenationTree::optimizeLayout). With a single node, this is
+          *  one such copy. The nodes must outlive the registry. */
+         DictionaryRegistry(const NumaNodes &nodes);
+
+         /** Destroys all dictionaries loaded through this registry. */
+         ~DictionaryRegistry();
+
+         /** Returns the registry used by Hyphenator, which lives as long
+          *  as the process. It keeps a copy per node of
+          *  NumaNodes::system() if the machine has more than one node.
+          *  Setting the environment variable LIBHYPHENATE_REPLICATE to 0
+          *  turns this off, and to any other value turns it on even with
+          *  a single node. */
+         static DictionaryRegistry &standard();
+
+         /** Returns the given node's copy of the tree for the pattern file
+          *  of the entry, loading all copies on first use. Throws a
+          *  domain_error if the entry is a dialect, the file cannot be
+          *  loaded or there is no such node. */
+         const HyphenationTree &tree(const PatternCatalog::Entry &entry,
+            size_t node = 0);
+
+         /** Returns the given node's copy of the dialect for the entry,
+          *  loading it and its base from the catalog on first use. The
+          *  base must be a pattern file, not another dialect. Throws a
+          *  domain_error if the entry has no base, a file cannot be
+          *  loaded or there is no such node. */
+         const OverlayDictionary &dialect(const PatternCatalog &catalog,
+            const PatternCatalog::Entry &entry, size_t node = 0);
+
+         /** The nodes the dictionaries are copied for, or NULL if the
+          *  registry keeps a single, ordinary copy. */
+         const NumaNodes *nodes() const { return numa_nodes; }
+
+         /** The number of copies of each dictionary. */
+         size_t copies() const;
+
+         /** The number of distinct trees and dialects loaded, not counting
+          *  copies. */
+         size_t size() const;
+
+      private:
+         typedef std::pair<UInt64, off_t> Key;
+         typedef std::map<Key, RegistrySlot*> SlotMap;
+
+         const NumaNodes *numa_nodes;
+         mutable pthread_mutex_t lock;
+         pthread_cond_t loaded;
+         SlotMap trees, dialects;
+
+         bool claim(SlotMap &slots, const Key &key, RegistrySlot *&slot);
+         void finish(SlotMap &slots, const Key &key, RegistrySlot *slot);
+         void wait(RegistrySlot *slot);
+         void check_node(size_t node) const;
+         const std::vector<HyphenationTree*> &trees_for(
+            const PatternCatalog::Entry &entry);
+
+         DictionaryRegistry(const DictionaryRegistry &);
+         DictionaryRegistry &operator=(const DictionaryRegistry &);
+   };
+}
+
+#endif
@@ -27,7 +27,7 @@
 using namespace std;
 
 Hyphenate::HyphenationRule::HyphenationRule(CFStringRef dpattern_string)
-: del_pre(0), skip_post(0)
+: del_pre(0), skip_post(0), id(0)
 {
    CFIndex dpattern_length = CFStringGetLength(dpattern_string);
    UniChar *dpattern = new UniChar[dpattern_length];
@@ -54,7 +54,7 @@ Hyphenate::HyphenationRule::HyphenationRule(CFStringRef dpattern_string)
 
    /* Complete and simplify the array. */
    priorities.push_back(priority);
-   while (priorities.back() == 0) priorities.pop_back();
+   while (!priorities.empty() && priorities.back() == 0) priorities.pop_back();
 
    /* Now check for nonstandard hyphenation. First, parse it. */
    if (i < dpattern_length && dpattern[i] == '/') {
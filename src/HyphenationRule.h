@@ -27,6 +27,8 @@
 #include <CoreFoundation/CoreFoundation.h>
 
 namespace Hyphenate {
+   class HyphenationTree;
+
    /** The HyphenationRule class represents a single Hyphenation Rule, that
     *  is, a pattern that has a number assigned to each letter and will,
     *  if applied, hyphenate a word at the given point. The number assigned
@@ -41,6 +43,11 @@ namespace Hyphenate {
 
          std::string replacement;
 
+         /* The number HyphenationTree::ruleId gives the rule, set by the
+          * tree that owns it. */
+         int id;
+         friend class HyphenationTree;
+
       public:
          /* HyphenationRule is constructed from a string consisting of
           * letters with numbers strewn in. The numbers are the priorities.
@@ -82,7 +89,15 @@ namespace Hyphenate {
           *  at the given offset. */
          inline char priority(uint offset) const { return priorities[offset]; }
 
-         /** Returns the pattern to match for this rule to apply. */
+         /** Returns the pattern to match for this rule to apply, or NULL
+          *  if the pattern has no letters.
+          *
+          *  This is only meaningful for rules made from a pattern. A
+          *  HyphenationTree reports the same rule for every standard
+          *  pattern, which has no key and no priorities of its own; the
+          *  priorities it keeps are reported by applyPatterns instead. Only
+          *  non-standard rules returned by a tree are the patterns they
+          *  were made from. */
          inline CFStringRef getKey() { return key; }
 
          /** Returns the amount of bytes that will additionally be needed
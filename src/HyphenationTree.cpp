@@ -24,6 +24,9 @@
 /* ------------- Implementation for HyphenationTree.h ---------------- */
 
 #include "HyphenationTree.h"
+#include "Checksum.h"
+#include "NodeProfile.h"
+#include <fstream>
 #include <iostream>
 #include <stdexcept>
 #include <algorithm>
@@ -31,21 +34,26 @@
 using namespace std;
 using namespace Hyphenate;
 
+/* Words up to this length are hyphenated with buffers on the stack. */
+#define SHORT_WORD 64
+
 /* The HyphenationNode is a tree node for the hyphenation search tree. It
 * represents the matching state after a single character; if there is a
-* pattern that ends with that particular character, the hyphenation_pattern
-* is set to non-NULL. The jump_table links to the children of that node,
-* indexed by letters. */
+* pattern that ends with that particular character, ops is the index of its
+* priorities in the tree's op table and rule is set to non-NULL. The
+* jump_table links to the children of that node, indexed by letters. */
 class Hyphenate::HyphenationNode {
    public:
       typedef std::map<UniChar, HyphenationNode*> JumpMap;
       /* Table of children */
       HyphenationNode* jump_table[26];
       JumpMap *jump_map;
-      /* Hyphenation pattern associated with the full path to this node. */
-      std::auto_ptr<HyphenationRule> hyphenation_pattern;
+      /* Hyphenation pattern associated with the full path to this node. The
+       * rule is owned by the tree. */
+      UInt32 ops;
+      const HyphenationRule *rule;
 
-      HyphenationNode() : jump_map(NULL) {
+      HyphenationNode() : jump_map(NULL), ops(0), rule(NULL) {
 	 memset((void *)jump_table, 0, 26 * sizeof(HyphenationNode*));
       }
 	 
@@ -92,32 +100,179 @@ class Hyphenate::HyphenationNode {
    
       /** Insert a particular hyphenation pattern into this 
          *  hyphenation subtree.
-      * \param pattern The character pattern to match in the input word.
-      * \param hp The digit-pattern for the hyphenation algorithm.
+      * \param id The character pattern to match in the input word.
+      * \param ops The index of the pattern's priorities in the op table.
+      * \param rule The rule to report where the pattern hyphenates.
       */
-      void insert (const UniChar *id, 
-         std::auto_ptr<HyphenationRule> pattern);
+      void insert (const UniChar *id, UInt32 ops,
+         const HyphenationRule *rule);
+
+      /** Apply the pattern ending at this node, if any. */
+      inline void apply_ops(
+         char *priority_buffer, 
+         const HyphenationRule ** rule_buffer, 
+         const UInt16 *op_table) const
+      {
+         for (const UInt16 *op = op_table + ops; *op; op++) {
+            int offset = *op >> 4;
+            char priority = *op & 0xf;
+            if (priority_buffer[offset] < priority) {
+               rule_buffer[offset] = (priority % 2 == 1) ? rule : NULL;
+               priority_buffer[offset] = priority;
+            }
+         }
+      }
 
       /** Apply all patterns for that subtree. */
       void apply_patterns(
          char *priority_buffer, 
          const HyphenationRule ** rule_buffer, 
-         UniChar *to_match) const;
+         UniChar *to_match,
+         const UInt16 *op_table) const;
 };
 
+/* The sizes of the bitmaps of the letters starting a pattern. The pair
+ * bitmap grows with the patterns to about 16 bits for each, within these
+ * powers of two. Letters below 256 map to distinct bits of the singles. */
+#define MIN_START_PAIR_BITS 5
+#define MAX_START_PAIR_BITS 16
+#define START_SINGLES 256
+
+static inline UInt32 start_pair(UniChar first, UniChar second, int bits) {
+   /* The top bits of the product depend on both letters. */
+   return ((((UInt32)first << 16) | second) * 2654435761u) >> (32 - bits);
+}
+
+static inline UInt32 start_single(UniChar first) {
+   return first % START_SINGLES;
+}
+
+inline bool Hyphenate::HyphenationTree::may_start(const UniChar *suffix) const
+{
+   UInt32 single = start_single(suffix[0]);
+   if (start_singles[single / 32] & (1u << (single % 32)))
+      return true;
+   /* A suffix of one letter can only match single letter patterns. */
+   if (suffix[1] == 0)
+      return false;
+   UInt32 pair = start_pair(suffix[0], suffix[1], start_pair_bits);
+   return (start_pairs[pair / 32] & (1u << (pair % 32))) != 0;
+}
+
 Hyphenate::HyphenationTree::HyphenationTree() : 
-   root(new HyphenationNode()), start_safe(1), end_safe(1) {
+   root(new HyphenationNode()), start_safe(1), end_safe(1),
+   ops(1, 0), standard_rule(new HyphenationRule(CFSTR("1"))),
+   max_pattern_length(0), start_pairs((1 << MIN_START_PAIR_BITS) / 32, 0),
+   start_singles(START_SINGLES / 32, 0),
+   start_pair_bits(MIN_START_PAIR_BITS), pattern_count(0),
+   pattern_checksum(checksum_seed),
+   arena(NULL), arena_size(0) {
       non_lower_case_letter_characte_set = CFCharacterSetCreateInvertedSet(kCFAllocatorDefault, CFCharacterSetGetPredefined(kCFCharacterSetLowercaseLetter));
 }
 
 Hyphenate::HyphenationTree::~HyphenationTree() {
-   delete root;
+   if (arena)
+      release_nodes();
+   else
+      delete root;
+   for (vector<HyphenationRule*>::iterator i = nonstandard_rules.begin();
+         i != nonstandard_rules.end(); i++)
+      delete *i;
    CFRelease(non_lower_case_letter_characte_set);
 }
 
+UInt32 Hyphenate::HyphenationTree::intern_ops(const HyphenationRule &pattern)
+{
+   vector<UInt16> chain;
+   for (uint i = 0; pattern.hasPriority(i) && i < 0x1000; i++) {
+      int priority = pattern.priority(i);
+      if (priority <= 0)
+         continue;
+      /* Four bits will do for any sensible pattern file; larger
+       * priorities are capped, keeping their parity. */
+      if (priority > 15)
+         priority = (priority % 2 == 1) ? 15 : 14;
+      chain.push_back((i << 4) | priority);
+   }
+   chain.push_back(0);
+
+   /* A pattern without digits gets the chain [0] too, but not index 0,
+    * which op_chains never holds: ops == 0 marks a node without a pattern,
+    * while a digit-less pattern in an overlay must show up as a pattern to
+    * hide the base's (see apply_layered_patterns). Index 0 is
+    * taken by the constructor, so every chain lands after it. */
+   map<vector<UInt16>, UInt32>::iterator known = op_chains.find(chain);
+   if (known != op_chains.end())
+      return known->second;
+
+   UInt32 index = ops.size();
+   ops.insert(ops.end(), chain.begin(), chain.end());
+   op_chains.insert(make_pair(chain, index));
+   return index;
+}
+
+int Hyphenate::HyphenationTree::ruleId(const HyphenationRule *r) const {
+   if (!r)
+      return -1;
+   if (r == standard_rule.get())
+      return 0;
+   /* The rule knows its number; make sure it is one of ours. */
+   int id = r->id;
+   if (id <= 0 || id > (int)nonstandard_rules.size() ||
+         nonstandard_rules[id - 1] != r)
+      return -1;
+   return id;
+}
+
+const HyphenationRule *Hyphenate::HyphenationTree::rule(int id) const {
+   if (id == 0)
+      return standard_rule.get();
+   if (id < 0 || id > (int)nonstandard_rules.size())
+      return NULL;
+   return nonstandard_rules[id - 1];
+}
+
+/* Append the children of node and the letters leading to them. */
+static void add_children(const HyphenationNode *node,
+   vector<pair<UniChar, const HyphenationNode*> > &children)
+{
+   for (int i = 0; i < 26; i++)
+      if (node->jump_table[i])
+         children.push_back(make_pair((UniChar)('a' + i),
+            (const HyphenationNode *)node->jump_table[i]));
+   if (node->jump_map)
+      for (HyphenationNode::JumpMap::iterator i = node->jump_map->begin();
+            i != node->jump_map->end(); i++)
+         children.push_back(make_pair(i->first,
+            (const HyphenationNode *)i->second));
+}
+
+void Hyphenate::HyphenationTree::grow_start_pairs() {
+   while (pattern_count * 16 > (1u << start_pair_bits) &&
+         start_pair_bits < MAX_START_PAIR_BITS)
+      start_pair_bits++;
+   start_pairs.assign((1 << start_pair_bits) / 32, 0);
+
+   /* The first two letters of the patterns inserted so far are the first
+    * two levels of the tree. */
+   vector<pair<UniChar, const HyphenationNode*> > firsts;
+   add_children(root, firsts);
+   for (size_t f = 0; f < firsts.size(); f++) {
+      vector<pair<UniChar, const HyphenationNode*> > seconds;
+      add_children(firsts[f].second, seconds);
+      for (size_t s = 0; s < seconds.size(); s++) {
+         UInt32 pair = start_pair(firsts[f].first, seconds[s].first,
+            start_pair_bits);
+         start_pairs[pair / 32] |= 1u << (pair % 32);
+      }
+   }
+}
+
 void Hyphenate::HyphenationTree::insert(auto_ptr<HyphenationRule> pattern) {
    /* Convert our key to lower case to ease matching. */
    CFStringRef upperCaseKey = pattern->getKey();
+   if (!upperCaseKey)
+      return;
    CFIndex length = CFStringGetLength(upperCaseKey);
    CFMutableStringRef lowercaseKey = CFStringCreateMutableCopy(kCFAllocatorDefault, length, upperCaseKey);
    CFStringLowercase(lowercaseKey, NULL);
@@ -125,20 +280,53 @@ void Hyphenate::HyphenationTree::insert(auto_ptr<HyphenationRule> pattern) {
    CFStringGetCharacters(lowercaseKey, CFRangeMake(0, length), lowercaseKeyCharacters);
    lowercaseKeyCharacters[length] = 0;
    CFRelease(lowercaseKey);
+   max_pattern_length = max(max_pattern_length, length);
+   pattern_count++;
+   if (pattern_count * 16 > (1u << start_pair_bits) &&
+         start_pair_bits < MAX_START_PAIR_BITS)
+      grow_start_pairs();
+   if (length == 1) {
+      UInt32 single = start_single(lowercaseKeyCharacters[0]);
+      start_singles[single / 32] |= 1u << (single % 32);
+   } else if (length > 1) {
+      UInt32 pair = start_pair(lowercaseKeyCharacters[0],
+                               lowercaseKeyCharacters[1], start_pair_bits);
+      start_pairs[pair / 32] |= 1u << (pair % 32);
+   }
+
+   UInt32 pattern_ops = intern_ops(*pattern);
+   const HyphenationRule *rule = standard_rule.get();
+   UInt8 nonstandard = pattern->isNonStandard();
+   pattern_checksum = checksum(lowercaseKeyCharacters,
+      (length + 1) * sizeof(UniChar), pattern_checksum);
+   for (const UInt16 *op = &ops[pattern_ops]; ; op++) {
+      pattern_checksum = checksum(op, sizeof(*op), pattern_checksum);
+      if (!*op)
+         break;
+   }
+   pattern_checksum = checksum(&nonstandard, sizeof(nonstandard),
+      pattern_checksum);
+   if (nonstandard) {
+      nonstandard_rules.push_back(pattern.get());
+      pattern->id = nonstandard_rules.size();
+      rule = pattern.release();
+   }
 
-   root->insert(lowercaseKeyCharacters, pattern);
+   root->insert(lowercaseKeyCharacters, pattern_ops, rule);
    delete[] lowercaseKeyCharacters;
 }
 
 void HyphenationNode::insert (const UniChar* key_characters, 
-                              auto_ptr<HyphenationRule> pattern) 
+                              UInt32 pattern_ops,
+                              const HyphenationRule *pattern_rule) 
 {
    /* Is this the terminal node for that pattern? */
    if (key_characters[0] == 0) {
       /* If we descended the tree all the way to the last letter, we can now
        * write the pattern into this node. */
 
-      hyphenation_pattern.reset(pattern.release());
+      ops = pattern_ops;
+      rule = pattern_rule;
    } else  {
       /* If not, however, we make sure that the branch for our letter exists
        * and descend. */
@@ -156,14 +344,15 @@ void HyphenationNode::insert (const UniChar* key_characters,
 	 }
       }
       /* Go to the next letter and descend. */
-      p->insert(key_characters+1, pattern);
+      p->insert(key_characters+1, pattern_ops, pattern_rule);
    }
 }
 
 void Hyphenate::HyphenationNode::apply_patterns(
    char *priority_buffer, 
    const HyphenationRule ** rule_buffer, 
-   UniChar *to_match) const
+   UniChar *to_match,
+   const UInt16 *op_table) const
 {
    /* First of all, if we can descend further into the tree (that is,
     * there is an input char left and there is a branch in the tree),
@@ -173,18 +362,50 @@ void Hyphenate::HyphenationNode::apply_patterns(
    if (key != 0) {
       const HyphenationNode *next = find(key);
       if ( next != NULL )
-         next->apply_patterns(priority_buffer, rule_buffer, to_match+1);
+         next->apply_patterns(priority_buffer, rule_buffer, to_match+1,
+                              op_table);
    }
 
    /* Now, if we have a pattern at this point in the tree, it must be a good
-    * match. Apply the pattern. */
-   const HyphenationRule* hyp_pat = hyphenation_pattern.get();
-   if (hyp_pat != NULL)
-      for (int i = 0; hyp_pat->hasPriority(i); i++)
-	 if (priority_buffer[i] < hyp_pat->priority(i)) {
-            rule_buffer[i] = (hyp_pat->priority(i) % 2 == 1) ? hyp_pat : NULL;
-            priority_buffer[i] = hyp_pat->priority(i);
-         }
+    * match. Apply the pattern by walking its op chain. */
+   apply_ops(priority_buffer, rule_buffer, op_table);
+}
+
+/* Apply the patterns of two trees as if they were one, descending both in
+ * parallel. Where both trees have a pattern for the same letters, the one
+ * in the overlay replaces the one in the base, just like a later insert
+ * into a single tree would. Either node may be NULL. */
+static void apply_layered_patterns(
+   const HyphenationNode *base,
+   const HyphenationNode *overlay,
+   char *priority_buffer, 
+   const HyphenationRule ** rule_buffer, 
+   UniChar *to_match,
+   const UInt16 *base_ops,
+   const UInt16 *overlay_ops)
+{
+   UniChar key = to_match[0];
+
+   if (key != 0) {
+      const HyphenationNode *next_base = base ? base->find(key) : NULL;
+      const HyphenationNode *next_overlay = overlay ? overlay->find(key) : NULL;
+      /* Once one of the trees runs out, the other is on its own. */
+      if (next_overlay == NULL) {
+         if (next_base != NULL)
+            next_base->apply_patterns(priority_buffer, rule_buffer,
+                                      to_match+1, base_ops);
+      } else if (next_base == NULL) {
+         next_overlay->apply_patterns(priority_buffer, rule_buffer,
+                                      to_match+1, overlay_ops);
+      } else
+         apply_layered_patterns(next_base, next_overlay, priority_buffer,
+            rule_buffer, to_match+1, base_ops, overlay_ops);
+   }
+
+   if (overlay && overlay->ops)
+      overlay->apply_ops(priority_buffer, rule_buffer, overlay_ops);
+   else if (base)
+      base->apply_ops(priority_buffer, rule_buffer, base_ops);
 }
 
 auto_ptr<vector<const HyphenationRule*> > HyphenationTree::applyPatterns
@@ -195,6 +416,13 @@ auto_ptr<vector<const HyphenationRule*> > HyphenationTree::applyPatterns
 
 auto_ptr<vector<const HyphenationRule*> > HyphenationTree::applyPatterns
    (CFStringRef word, CFIndex stop_at) const
+{
+   return apply_patterns(word, stop_at, NULL, NULL);
+}
+
+auto_ptr<vector<const HyphenationRule*> > HyphenationTree::apply_patterns
+   (CFStringRef word, CFIndex stop_at, const HyphenationTree *overlay,
+    UInt8 *priorities) const
 {
    /* Prepend and append a . to the string (word start and end), and convert
     * all characters to lower case to ease matching. */   
@@ -211,61 +439,259 @@ auto_ptr<vector<const HyphenationRule*> > HyphenationTree::applyPatterns
       lowerCaseStringToRelease = NULL;
    }
       
-   CFIndex w_size = wordLength + 2;
-   UniChar *characters = new UniChar[w_size + 1];
+   UniChar *characters = new UniChar[wordLength + 3];
    characters[0] = '.';
    CFStringGetCharacters(word, CFRangeMake(0, wordLength), characters + 1);
    characters[wordLength + 1] = '.';
    characters[wordLength + 2] = 0;
+
+   auto_ptr<vector<const HyphenationRule*> > output_rules(
+      new vector<const HyphenationRule*>(wordLength,
+         (const HyphenationRule*)NULL));
+   if (wordLength)
+      apply_patterns(characters, wordLength, stop_at, &(*output_rules)[0],
+         overlay, priorities);
+
+   if(lowerCaseStringToRelease) 
+      CFRelease(lowerCaseStringToRelease);
    
-   /* Arrays for priorities and rules. */
-   char *pri = (char *)calloc(w_size + 2, sizeof(char));
-   const HyphenationRule **rules = (const HyphenationRule **)calloc(w_size + 3, sizeof(HyphenationRule *));
+   delete[] characters;
+   
+   return output_rules;
+}
+
+/* Copy the word to characters, lowercased and enclosed in dots, leaving
+ * room for a terminating NUL. Lowercase ASCII right away; anything else
+ * needs CoreFoundation, but only if there is an uppercase letter at all.
+ * Returns false if lowercasing would change the length of the word. */
+static bool dot_and_lowercase(const UniChar *word, CFIndex wordLength,
+   UniChar *characters)
+{
+   CFCharacterSetRef upperCaseLetterCharacterSet = CFCharacterSetGetPredefined(kCFCharacterSetUppercaseLetter);
+   characters[0] = '.';
+   bool upper = false;
+   for (CFIndex i = 0; i < wordLength; i++) {
+      UniChar c = word[i];
+      if (c >= 'A' && c <= 'Z')
+         c += 'a' - 'A';
+      else if (c >= 0x80 && !upper)
+         /* Letters outside the BMP come as surrogate pairs, which only
+          * a CFString can classify. */
+         upper = (c >= 0xd800 && c <= 0xdfff) ||
+            CFCharacterSetIsCharacterMember(upperCaseLetterCharacterSet, c);
+      characters[i + 1] = c;
+   }
+   characters[wordLength + 1] = '.';
+   characters[wordLength + 2] = 0;
+
+   if (!upper)
+      return true;
+   bool same_length = true;
+   CFStringRef wordString = CFStringCreateWithCharactersNoCopy(kCFAllocatorDefault, word, wordLength, kCFAllocatorNull);
+   CFRange foundRange;
+   if (CFStringFindCharacterFromSet(wordString, upperCaseLetterCharacterSet, CFRangeMake(0, wordLength), 0, &foundRange)) {
+      CFMutableStringRef lowerCaseString = CFStringCreateMutableCopy(kCFAllocatorDefault, wordLength, wordString);
+      CFStringLowercase(lowerCaseString, NULL);
+      same_length = CFStringGetLength(lowerCaseString) == wordLength;
+      if (same_length)
+         CFStringGetCharacters(lowerCaseString, CFRangeMake(0, wordLength), characters + 1);
+      CFRelease(lowerCaseString);
+   }
+   CFRelease(wordString);
+   return same_length;
+}
+
+void HyphenationTree::applyPatterns(const UniChar *word, CFIndex wordLength,
+   const HyphenationRule **output, UInt8 *priorities) const
+{
+   apply_patterns(word, wordLength, output, priorities, NULL);
+}
+
+void HyphenationTree::apply_patterns(const UniChar *word, CFIndex wordLength,
+   const HyphenationRule **output, UInt8 *priorities,
+   const HyphenationTree *overlay) const
+{
+   UniChar short_characters[SHORT_WORD + 3];
+   UniChar *characters = (wordLength > SHORT_WORD)
+      ? new UniChar[wordLength + 3] : short_characters;
+   if (!dot_and_lowercase(word, wordLength, characters)) {
+      /* Leave the odd cases to the CFString implementation. */
+      CFStringRef wordString = CFStringCreateWithCharactersNoCopy(kCFAllocatorDefault, word, wordLength, kCFAllocatorNull);
+      auto_ptr<vector<const HyphenationRule*> > rules =
+         apply_patterns(wordString, INT_MAX, overlay, priorities);
+      copy(rules->begin(), rules->end(), output);
+      CFRelease(wordString);
+   } else {
+      fill(output, output + wordLength, (const HyphenationRule*)NULL);
+      apply_patterns(characters, wordLength, INT_MAX, output, overlay,
+         priorities);
+   }
+   if (characters != short_characters)
+      delete[] characters;
+}
+
+void HyphenationTree::apply_patterns(UniChar *characters, CFIndex wordLength,
+   CFIndex stop_at, const HyphenationRule **output,
+   const HyphenationTree *overlay, UInt8 *priorities) const
+{
+   CFIndex w_size = wordLength + 2;
+
+   /* Arrays for priorities and rules, on the stack for short words. */
+   char short_pri[SHORT_WORD + 4];
+   const HyphenationRule *short_rules[SHORT_WORD + 5];
+   char *pri = short_pri;
+   const HyphenationRule **rules = short_rules;
+   if (wordLength > SHORT_WORD) {
+      pri = (char *)calloc(w_size + 2, sizeof(char));
+      rules = (const HyphenationRule **)calloc(w_size + 3, sizeof(HyphenationRule *));
+   } else {
+      memset(pri, 0, (w_size + 2) * sizeof(char));
+      memset((void *)rules, 0, (w_size + 3) * sizeof(HyphenationRule *));
+   }
     
    /* For each suffix of the expanded word, search all matching prefixes.
     * That way, each possible match is found. Note the pointer arithmetics
     * in the first and second argument. */
-   for (CFIndex i = 0; i < w_size-1 && i <= stop_at; i++)
-      root->apply_patterns((&pri[i]), (&rules[i]), characters + i);
+   if (overlay) {
+      for (CFIndex i = 0; i < w_size-1 && i <= stop_at; i++)
+         if (may_start(characters + i) || overlay->may_start(characters + i))
+            apply_layered_patterns(root, overlay->root, (&pri[i]),
+               (&rules[i]), characters + i, &ops[0], &overlay->ops[0]);
+   } else {
+      for (CFIndex i = 0; i < w_size-1 && i <= stop_at; i++)
+         if (may_start(characters + i))
+            root->apply_patterns((&pri[i]), (&rules[i]), characters + i,
+                                 &ops[0]);
+   }
+
+   apply_safe_areas(characters, wordLength, rules, output);
+   if (priorities)
+      for (CFIndex i = 0; i < wordLength; i++)
+         priorities[i] = output[i] ? pri[i + 1] : 0;
+   if (pri != short_pri) {
+      free(pri);
+      free(rules);
+   }
+}
+
+void HyphenationTree::apply_safe_areas(const UniChar *characters,
+   CFIndex wordLength, const HyphenationRule *const *rules,
+   const HyphenationRule **output) const
+{
+   CFIndex w_size = wordLength + 2;
 
-   free(pri);
-   
-   /* Copy the results to a shorter vector. */
-   auto_ptr<vector<const HyphenationRule*> > output_rules(
-      new vector<const HyphenationRule*>(wordLength, NULL));
-   
    /* We honor the safe areas at the start and end of each word here. */
    /* Please note that the incongruence between start and end is due
-    * to the fact that hyphenation happens _before_ each character. */
-   uint ind_start = 1 + start_safe, ind_end = w_size - 1 - end_safe;
+    * to the fact that hyphenation happens _before_ each character. With
+    * no safe area at the end, the position after the last letter is not
+    * one of the word's and must not be written. */
+   CFIndex ind_start = max((CFIndex)1, 1 + start_safe);
+   CFIndex ind_end = min(wordLength, w_size - 1 - end_safe);
    
-   for (uint i = ind_start; i <= ind_end; i++)
-      (*output_rules)[i - 1] = rules[i];
+   for (CFIndex i = ind_start; i <= ind_end; i++)
+      output[i - 1] = rules[i];
    
    /* Remove any hyphens within the safe-distance of punctuation */
-   CFRange searchRange = CFRangeMake(0, wordLength);
-   while (CFStringFindCharacterFromSet(word, non_lower_case_letter_characte_set, searchRange, 0, &foundRange)) {
-      CFIndex i = max(searchRange.location, foundRange.location - start_safe);
-      CFIndex upTo = min(wordLength, foundRange.location + foundRange.length + end_safe);
+   for (CFIndex q = 0; q < wordLength; q++) {
+      if (!CFCharacterSetIsCharacterMember(non_lower_case_letter_characte_set, characters[q + 1]))
+         continue;
+      CFIndex i = max((CFIndex)0, q - start_safe);
+      CFIndex upTo = min(wordLength, q + 1 + end_safe);
       for (; i < upTo; ++i) {
-         (*output_rules)[i] = NULL;
+         output[i] = NULL;
       }
-      if(upTo == wordLength) {
-         // May as well break, we've zeroed out th the end of the word.
-         break;
+   }
+}
+
+auto_ptr<vector<const HyphenationRule*> > HyphenationTree::applyPatterns
+   (CFStringRef word, CFRange range) const
+{
+   CFIndex wordLength = CFStringGetLength(word);
+   CFIndex from = max((CFIndex)0, range.location);
+   CFIndex to = min(wordLength, range.location + range.length);
+   auto_ptr<vector<const HyphenationRule*> > output_rules(
+      new vector<const HyphenationRule*>(max((CFIndex)0, to - from),
+         (const HyphenationRule*)NULL));
+   if (from >= to)
+      return output_rules;
+
+   /* We work on the dotted word, as applyPatterns does: index d is the
+    * word's letter d-1, and the hyphen before it goes to rules[d]. Only the
+    * suffixes starting at most max_pattern_length before the range can
+    * reach into it, and they read at most max_pattern_length letters. The
+    * letters within the safe areas around the range are needed to find
+    * punctuation. */
+   CFIndex w_size = wordLength + 2;
+   CFIndex first_suffix = max((CFIndex)0, from + 1 - max_pattern_length);
+   CFIndex last_suffix = min(w_size - 2, to);
+   CFIndex lo = max((CFIndex)0, min(first_suffix, from + 1 - end_safe));
+   CFIndex hi = min(w_size, max(to + max_pattern_length,
+      to + 1 + start_safe));
+
+   /* Copy and lowercase only the letters in [lo, hi). Should lowercasing
+    * change the length of the word, positions in the lowercased word no
+    * longer match the original; hyphenate all of it then. */
+   CFIndex first_letter = max((CFIndex)1, lo) - 1;
+   CFIndex letters = min(w_size - 1, hi) - 1 - first_letter;
+   UniChar *characters = new UniChar[hi - lo + 1];
+   UniChar *letter_buffer = characters + (lo == 0 ? 1 : 0);
+   CFRange letterRange = CFRangeMake(first_letter, letters);
+   CFRange foundRange;
+   if (CFStringFindCharacterFromSet(word, CFCharacterSetGetPredefined(kCFCharacterSetUppercaseLetter), letterRange, 0, &foundRange)) {
+      CFStringRef substring = CFStringCreateWithSubstring(kCFAllocatorDefault, word, letterRange);
+      CFMutableStringRef lowerCaseString = CFStringCreateMutableCopy(kCFAllocatorDefault, letters, substring);
+      CFStringLowercase(lowerCaseString, NULL);
+      CFRelease(substring);
+      if (CFStringGetLength(lowerCaseString) != letters) {
+         CFRelease(lowerCaseString);
+         delete[] characters;
+         auto_ptr<vector<const HyphenationRule*> > all = applyPatterns(word);
+         copy(all->begin() + from, all->begin() + to, output_rules->begin());
+         return output_rules;
       }
-      searchRange.location = searchRange.location + searchRange.length;
-      searchRange.length = wordLength - searchRange.location;
+      CFStringGetCharacters(lowerCaseString, CFRangeMake(0, letters), letter_buffer);
+      CFRelease(lowerCaseString);
+   } else
+      CFStringGetCharacters(word, letterRange, letter_buffer);
+   if (lo == 0)
+      characters[0] = '.';
+   if (hi == w_size)
+      characters[hi - lo - 1] = '.';
+   characters[hi - lo] = 0;
+
+   /* Arrays for priorities and rules, relative to lo. */
+   char *pri = (char *)calloc(hi - lo + 2, sizeof(char));
+   const HyphenationRule **rules = (const HyphenationRule **)calloc(hi - lo + 2, sizeof(HyphenationRule *));
+
+   for (CFIndex i = first_suffix; i <= last_suffix; i++)
+      if (may_start(characters + (i - lo)))
+         root->apply_patterns((&pri[i - lo]), (&rules[i - lo]),
+            characters + (i - lo), &ops[0]);
+
+   /* Honor the safe areas at the start and end of the word and around
+    * punctuation, just like applyPatterns. The letter at index q of the
+    * word suppresses the hyphens before the letters q - start_safe up to
+    * q + end_safe. */
+   CFIndex ind_start = max((CFIndex)1, 1 + start_safe);
+   CFIndex ind_end = min(wordLength, w_size - 1 - end_safe);
+   for (CFIndex j = from; j < to; j++) {
+      CFIndex d = j + 1;
+      if (d < ind_start || d > ind_end)
+         continue;
+
+      bool punctuation = false;
+      for (CFIndex q = max((CFIndex)0, j - end_safe);
+            q <= min(wordLength - 1, j + start_safe) && !punctuation; q++)
+         punctuation = CFCharacterSetIsCharacterMember(
+            non_lower_case_letter_characte_set, characters[q + 1 - lo]);
+      if (!punctuation)
+         (*output_rules)[j - from] = rules[d - lo];
    }
-   
-   
+
+   free(pri);
    free(rules);
-   
-   if(lowerCaseStringToRelease) 
-      CFRelease(lowerCaseStringToRelease);
-   
    delete[] characters;
-   
+
    return output_rules;
 }
 
@@ -282,7 +708,9 @@ void HyphenationTree::loadPatterns(istream &i) {
       if (ch == '\n' || ch == '\r' || ch == '\t' || ch == ' ') {
 	 /* The output operation. */
          if (pattern.size() && numeric && num_field <= 1) {
-            ((num_field == 0) ? start_safe : end_safe) = atoi(pattern.c_str());
+            UInt32 safe = atoi(pattern.c_str());
+            ((num_field == 0) ? start_safe : end_safe) = safe;
+            pattern_checksum = checksum(&safe, sizeof(safe), pattern_checksum);
             num_field++;
 	 } else if (pattern.size()) {
 	    CFStringRef patternString = CFStringCreateWithBytesNoCopy(kCFAllocatorDefault, (UInt8 *)pattern.c_str(), pattern.size(), kCFStringEncodingUTF8, false, kCFAllocatorNull);
@@ -311,3 +739,174 @@ void HyphenationTree::loadPatterns(istream &i) {
    }
 }
 
+void HyphenationTree::loadPatterns(const char *filename) {
+   ifstream i(filename, fstream::in);
+   if (!i)
+      throw domain_error(string("libhyphenate-cfstring: Cannot read pattern "
+         "file ") + filename);
+   loadPatterns(i);
+
+   /* A profile saved next to the patterns arranges the tree for speed. */
+   ifstream p(NodeProfile::pathFor(filename).c_str(), fstream::in);
+   if (p) {
+      NodeProfile profile;
+      profile.load(p);
+      if (profile.patternChecksum() == pattern_checksum)
+         optimizeLayout(profile);
+   }
+}
+
+/* Collect all nodes below root in breadth-first order and, if paths is
+ * given, the letters leading to each. */
+static void collect_nodes(HyphenationNode *root,
+   vector<HyphenationNode*> &nodes, vector<vector<UniChar> > *paths)
+{
+   nodes.push_back(root);
+   if (paths)
+      paths->push_back(vector<UniChar>());
+   for (size_t n = 0; n < nodes.size(); n++) {
+      HyphenationNode *node = nodes[n];
+      for (int i = 0; i < 26; i++) {
+         if (!node->jump_table[i])
+            continue;
+         nodes.push_back(node->jump_table[i]);
+         if (paths) {
+            paths->push_back((*paths)[n]);
+            paths->back().push_back('a' + i);
+         }
+      }
+      if (!node->jump_map)
+         continue;
+      for (HyphenationNode::JumpMap::iterator i = node->jump_map->begin();
+            i != node->jump_map->end(); i++) {
+         nodes.push_back(i->second);
+         if (paths) {
+            paths->push_back((*paths)[n]);
+            paths->back().push_back(i->first);
+         }
+      }
+   }
+}
+
+/* The UTF-8 form of the letters leading to a node, as used in NodeProfile. */
+static string profile_path(const vector<UniChar> &path) {
+   if (path.empty())
+      return string();
+   CFStringRef pathString = CFStringCreateWithCharacters(kCFAllocatorDefault, &path[0], path.size());
+   CFIndex size = CFStringGetMaximumSizeForEncoding(path.size(), kCFStringEncodingUTF8) + 1;
+   vector<char> buffer(size);
+   CFStringGetCString(pathString, &buffer[0], size, kCFStringEncodingUTF8);
+   CFRelease(pathString);
+   return string(&buffer[0]);
+}
+
+void HyphenationTree::release_nodes() {
+   /* Cut all links first, so that deleting a node does not delete its
+    * children, then delete the nodes outside of the arena one by one. */
+   vector<HyphenationNode*> nodes;
+   collect_nodes(root, nodes, NULL);
+   for (vector<HyphenationNode*>::iterator i = nodes.begin();
+         i != nodes.end(); i++) {
+      memset((void *)(*i)->jump_table, 0, 26 * sizeof(HyphenationNode*));
+      delete (*i)->jump_map;
+      (*i)->jump_map = NULL;
+   }
+   for (vector<HyphenationNode*>::iterator i = nodes.begin();
+         i != nodes.end(); i++)
+      if (*i < arena || *i >= arena + arena_size)
+         delete *i;
+   delete[] arena;
+   arena = NULL;
+   arena_size = 0;
+   root = NULL;
+}
+
+void HyphenationTree::profile(istream &corpus, NodeProfile &profile) const {
+   map<const HyphenationNode*, unsigned long> visits;
+   profile.setPatternChecksum(pattern_checksum);
+
+   string word;
+   while (corpus >> word) {
+      CFStringRef wordString = CFStringCreateWithBytes(kCFAllocatorDefault, (const UInt8 *)word.data(), word.size(), kCFStringEncodingUTF8, false);
+      if (!wordString)
+         continue;
+      CFMutableStringRef lowerCaseString = CFStringCreateMutableCopy(kCFAllocatorDefault, 0, wordString);
+      CFStringLowercase(lowerCaseString, NULL);
+      CFIndex wordLength = CFStringGetLength(lowerCaseString);
+      vector<UniChar> characters(wordLength + 3);
+      characters[0] = '.';
+      CFStringGetCharacters(lowerCaseString, CFRangeMake(0, wordLength), &characters[1]);
+      characters[wordLength + 1] = '.';
+      characters[wordLength + 2] = 0;
+      CFRelease(lowerCaseString);
+      CFRelease(wordString);
+
+      /* Visit the nodes just like apply_patterns does. */
+      for (CFIndex i = 0; i <= wordLength; i++) {
+         if (!may_start(&characters[i]))
+            continue;
+         const HyphenationNode *node = root;
+         for (CFIndex d = i; node; d++) {
+            visits[node]++;
+            node = characters[d] ? node->find(characters[d]) : NULL;
+         }
+      }
+   }
+
+   vector<HyphenationNode*> nodes;
+   vector<vector<UniChar> > paths;
+   collect_nodes(root, nodes, &paths);
+   for (size_t n = 0; n < nodes.size(); n++) {
+      map<const HyphenationNode*, unsigned long>::iterator v =
+         visits.find(nodes[n]);
+      if (v != visits.end())
+         profile.add(profile_path(paths[n]), v->second);
+   }
+}
+
+/* Orders nodes by descending visits, and by their breadth-first position
+ * where the visits are the same. */
+static bool more_visited(const pair<unsigned long, size_t> &a,
+   const pair<unsigned long, size_t> &b)
+{
+   return a.first > b.first || (a.first == b.first && a.second < b.second);
+}
+
+void HyphenationTree::optimizeLayout(const NodeProfile &profile) {
+   vector<HyphenationNode*> nodes;
+   vector<vector<UniChar> > paths;
+   collect_nodes(root, nodes, &paths);
+
+   vector<pair<unsigned long, size_t> > order;
+   for (size_t n = 0; n < nodes.size(); n++)
+      order.push_back(make_pair(profile.visits(profile_path(paths[n])), n));
+   sort(order.begin(), order.end(), more_visited);
+
+   /* Copy the nodes to their new places, then redirect all links. */
+   HyphenationNode *laid_out = new HyphenationNode[nodes.size()];
+   map<HyphenationNode*, HyphenationNode*> moved;
+   for (size_t k = 0; k < order.size(); k++) {
+      HyphenationNode *node = nodes[order[k].second];
+      laid_out[k].ops = node->ops;
+      laid_out[k].rule = node->rule;
+      moved[node] = &laid_out[k];
+   }
+   for (size_t n = 0; n < nodes.size(); n++) {
+      HyphenationNode *node = nodes[n], *copy = moved[node];
+      for (int i = 0; i < 26; i++)
+         if (node->jump_table[i])
+            copy->jump_table[i] = moved[node->jump_table[i]];
+      if (!node->jump_map)
+         continue;
+      copy->jump_map = new HyphenationNode::JumpMap();
+      for (HyphenationNode::JumpMap::iterator i = node->jump_map->begin();
+            i != node->jump_map->end(); i++)
+         copy->jump_map->insert(make_pair(i->first, moved[i->second]));
+   }
+
+   HyphenationNode *new_root = moved[root];
+   release_nodes();
+   root = new_root;
+   arena = laid_out;
+   arena_size = nodes.size();
+}
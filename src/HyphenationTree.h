@@ -26,11 +26,14 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
 #include <CoreFoundation/CoreFoundation.h>
 #include "HyphenationRule.h"
 
 namespace Hyphenate {
    class HyphenationNode;
+   class NodeProfile;
+   class OverlayDictionary;
    /**
    * \class HyphenationTree
    * \brief The root for a tree of HyphenationNodes.
@@ -41,6 +44,87 @@ namespace Hyphenate {
          CFIndex start_safe, end_safe;
          CFCharacterSetRef non_lower_case_letter_characte_set;
 
+         /* The priorities of all patterns, as in TeX: each terminal node
+          * refers to a chain of ops in this table, each op packing an
+          * offset into the pattern (upper 12 bits) and the priority for
+          * that offset (lower 4 bits). A chain ends with a 0 op, and
+          * index 0 is the empty chain for nodes without a pattern.
+          * Patterns with the same priorities share their chain. */
+         std::vector<UInt16> ops;
+         std::map<std::vector<UInt16>, UInt32> op_chains;
+
+         /* Standard patterns all behave alike when applied, so only the
+          * non-standard ones need a HyphenationRule of their own. */
+         std::auto_ptr<HyphenationRule> standard_rule;
+         std::vector<HyphenationRule*> nonstandard_rules;
+
+         /* The length of the longest pattern, which bounds how far a
+          * pattern can reach. */
+         CFIndex max_pattern_length;
+
+         /* Bitmaps of the (hashed) first two letters and of the single
+          * letters that patterns start with, kept up to date by insert.
+          * A suffix of a word that matches neither cannot match any
+          * pattern, so its descent can be skipped. The pair bitmap has
+          * 2^start_pair_bits bits and grows with the number of patterns,
+          * so that small trees, like those of OverlayDictionaries, stay
+          * small. */
+         std::vector<UInt32> start_pairs, start_singles;
+         int start_pair_bits;
+         size_t pattern_count;
+
+         inline bool may_start(const UniChar *suffix) const;
+         void grow_start_pairs();
+
+         /* The checksum of everything that affects the results of the
+          * tree, see patternChecksum. */
+         UInt64 pattern_checksum;
+
+         /* The block of nodes laid out by optimizeLayout, if any. Nodes
+          * inserted later are allocated one by one as usual. */
+         HyphenationNode *arena;
+         size_t arena_size;
+
+         /* Free all nodes, whether in the arena or not. */
+         void release_nodes();
+
+         UInt32 intern_ops(const HyphenationRule &pattern);
+
+         /* Apply the patterns to a word that has been lowercased, enclosed
+          * in dots and NUL-terminated, writing the rule for the position
+          * before each of its wordLength letters to output, and, if
+          * priorities is given, the priority of each hyphen (0 where
+          * there is none) to priorities. If overlay is given, its patterns
+          * are applied as if they had been inserted into this tree. */
+         void apply_patterns(UniChar *characters, CFIndex wordLength,
+            CFIndex stop_at, const HyphenationRule **output,
+            const HyphenationTree *overlay, UInt8 *priorities) const;
+
+         /* The implementation of applyPatterns for UTF-16 characters, with
+          * an optional overlay as above. */
+         void apply_patterns(const UniChar *word, CFIndex wordLength,
+            const HyphenationRule **output, UInt8 *priorities,
+            const HyphenationTree *overlay) const;
+
+         /* Take the rules found by apply_patterns for the dotted word,
+          * indexed by position in the dotted word, and write those outside
+          * of the safe areas at the start and end of the word and around
+          * punctuation to output. */
+         void apply_safe_areas(const UniChar *characters, CFIndex wordLength,
+            const HyphenationRule *const *rules,
+            const HyphenationRule **output) const;
+
+         /* The implementation of applyPatterns, with an optional overlay
+          * as above. */
+         std::auto_ptr<std::vector<const HyphenationRule*> > apply_patterns
+               (CFStringRef word, CFIndex stop_at,
+                const HyphenationTree *overlay, UInt8 *priorities) const;
+
+         friend class OverlayDictionary;
+
+         HyphenationTree(const HyphenationTree &);
+         HyphenationTree &operator=(const HyphenationTree &);
+
       public:
          /** The constructor constructs an empty tree, which can be filled
           *  either by reading a whole file of patterns with 
@@ -54,7 +138,16 @@ namespace Hyphenate {
           *  encountered will be the safe start, the second the safe end. */
          void loadPatterns(std::istream &source);
 
+         /** Read the patterns from the named file, as above. If a
+          *  NodeProfile for the same patterns has been saved next to the
+          *  file (see NodeProfile::pathFor), the tree is laid out by it;
+          *  a profile made for other patterns is ignored. Throws a
+          *  domain_error if the file cannot be read. */
+         void loadPatterns(const char *filename);
+
          /** Insert a particular hyphenation pattern into the hyphenation tree.
+         *  The tree keeps only the priorities of standard patterns, and
+         *  reports a single shared rule for all of them.
          *  \param pattern The character pattern to match in the input word.
          */
          void insert (std::auto_ptr<HyphenationRule> pattern);
@@ -62,7 +155,9 @@ namespace Hyphenate {
          /** Apply all patterns for that hyphenation tree to the supplied
           *  string. Return an array with Hyphenation rules that should be
           *  applied before the addition of the next letter of the string.
-          *  The pointers in that vector point into this tree. */
+          *  The pointers in that vector point into this tree. All standard
+          *  hyphens point to the same rule, rule(0), which stands for no
+          *  pattern in particular. */
          std::auto_ptr<std::vector<const HyphenationRule*> > applyPatterns
                (CFStringRef word) const; 
 
@@ -70,6 +165,60 @@ namespace Hyphenate {
           *  end_at. */
          std::auto_ptr<std::vector<const HyphenationRule*> > applyPatterns
                (CFStringRef word, CFIndex end_at) const; 
+
+         /** Like applyPattern, but for a word given as UTF-16 characters,
+          *  which need not be in a CFString. The rule for the position
+          *  before each letter is written to output, which must have room
+          *  for length entries. If priorities is given, it receives the
+          *  priority of the winning pattern for each hyphen, an odd number
+          *  from 1 up, and 0 where there is no hyphen. */
+         void applyPatterns(const UniChar *word, CFIndex length,
+               const HyphenationRule **output,
+               UInt8 *priorities = NULL) const;
+
+         /** Returns a checksum of the patterns and safe areas of the tree.
+          *  Trees with the same checksum hyphenate alike, so it
+          *  identifies the dictionary in a ResultCache. */
+         UInt64 patternChecksum() const { return pattern_checksum; }
+
+         /** Hyphenate the words of the corpus, a UTF-8 text of whitespace
+          *  separated words, and add the visits of each node of the tree
+          *  to the profile, which is marked as made for these patterns. */
+         void profile(std::istream &corpus, NodeProfile &profile) const;
+
+         /** Move all nodes into a single block of memory, ordered by the
+          *  number of visits in the profile, so that the nodes that are
+          *  used most lie next to each other and share pages. A node
+          *  spans several cache lines, and the maps for letters outside
+          *  a-z stay separate allocations, so this mostly saves TLB and
+          *  page misses rather than cache misses. Nodes without visits
+          *  follow in breadth-first order. This does not change the
+          *  results of the tree, only its speed. */
+         void optimizeLayout(const NodeProfile &profile);
+
+         /** Whether optimizeLayout has moved the nodes into a block. */
+         bool isLaidOut() const { return arena != NULL; }
+
+         /** Returns a number identifying the rule within this tree: 0 for
+          *  the rule shared by all standard patterns, and 1 and up for the
+          *  non-standard ones in the order they were inserted. NULL and
+          *  rules of other trees have the number -1. */
+         int ruleId(const HyphenationRule *rule) const;
+
+         /** Returns the rule with the given number, or NULL if there is
+          *  none. */
+         const HyphenationRule *rule(int id) const;
+
+         /** Like applyPattern, but will only hyphenate within the given
+          *  range of the word. Only the patterns that can reach into the
+          *  range are applied, which is much less work than hyphenating
+          *  the whole word if the range is short, e.g. when a line breaker
+          *  tests the few positions that fit on the current line.
+          *  \returns A vector with the size of the range, with the rule to
+          *           apply before the letter at range.location + i at
+          *           index i. */
+         std::auto_ptr<std::vector<const HyphenationRule*> > applyPatterns
+               (CFStringRef word, CFRange range) const; 
    };
 }
 
@@ -35,6 +35,11 @@
 
 #include "HyphenationRule.h"
 #include "HyphenationTree.h"
+#include "DictionaryRegistry.h"
+#include "NumaNodes.h"
+#include "OverlayDictionary.h"
+#include "PatternCatalog.h"
+#include "ResultCache.h"
 
 #define UTF8_MAX 6
 
@@ -42,15 +47,6 @@ using namespace std;
 using namespace RFC_3066;
 using namespace Hyphenate;
 
-/** The hyphenation table parser. */
-static auto_ptr<HyphenationTree> read_hyphenation_table(const char *filename) {
-   ifstream i (filename, fstream::in);
-   auto_ptr<HyphenationTree> output(new HyphenationTree());
-   output->loadPatterns(i);
-
-   return output;
-}
-
 /** Build a hyphenator for the given language. The hyphenation
    *  patterns for the language will loaded from a file named like
    *  the language string or any prefix of it. The file will be
@@ -61,34 +57,196 @@ static auto_ptr<HyphenationTree> read_hyphenation_table(const char *filename) {
    *
    * \param lang The language for which hyphenation patterns will be
    *             loaded. */
-Hyphenate::Hyphenator::Hyphenator(const RFC_3066::Language& lang) {
+Hyphenate::Hyphenator::Hyphenator(const RFC_3066::Language& lang)
+: cache(NULL)
+{
    setlocale(LC_CTYPE, "");
-   string path = "";
+   use_dictionary(lang, PatternCatalog::standard(),
+      DictionaryRegistry::standard());
+}
 
-   if (getenv("LIBHYPHENATE_PATH")) {
-      path = getenv("LIBHYPHENATE_PATH");
-   }
+Hyphenate::Hyphenator::Hyphenator(const RFC_3066::Language& lang,
+   const PatternCatalog& catalog)
+: cache(NULL)
+{
+   setlocale(LC_CTYPE, "");
+   use_dictionary(lang, catalog, DictionaryRegistry::standard());
+}
 
-#ifdef LIBHYPHENATE_DEFAULT_PATH
-   if (path == "")
-      path = LIBHYPHENATE_DEFAULT_PATH;
-#endif
+Hyphenate::Hyphenator::Hyphenator(const RFC_3066::Language& lang,
+   const PatternCatalog& catalog, DictionaryRegistry& registry)
+: cache(NULL)
+{
+   setlocale(LC_CTYPE, "");
+   use_dictionary(lang, catalog, registry);
+}
 
-   path += "/";
+/** Build a hyphenator from the patterns in the file provided. */
+Hyphenate::Hyphenator::Hyphenator(const char *filename)
+: owned_dictionary(new HyphenationTree()), nodes(NULL), cache(NULL)
+{
+   owned_dictionary->loadPatterns(filename);
+   dictionaries.push_back(owned_dictionary.get());
+   overlays.push_back(NULL);
+}
 
-   string filename = lang.find_suitable_file(path);
-   dictionary = read_hyphenation_table(filename.c_str());
+void Hyphenate::Hyphenator::use_dictionary(const RFC_3066::Language& lang,
+   const PatternCatalog& catalog, DictionaryRegistry& registry)
+{
+   const PatternCatalog::Entry &entry = catalog.resolve(lang);
+   nodes = registry.nodes();
+   for (size_t n = 0; n < registry.copies(); n++) {
+      if (entry.base.empty()) {
+         dictionaries.push_back(&registry.tree(entry, n));
+         overlays.push_back(NULL);
+      } else {
+         overlays.push_back(&registry.dialect(catalog, entry, n));
+         dictionaries.push_back(&overlays.back()->base());
+      }
+   }
 }
 
-/** Build a hyphenator from the patterns in the file provided. */
-Hyphenate::Hyphenator::Hyphenator(const char *filename) {
-   dictionary = read_hyphenation_table(filename);
+/* The copy of the patterns to use for the calling thread. */
+size_t Hyphenate::Hyphenator::local_node() const {
+   return nodes ? nodes->current() : 0;
 }
 
 Hyphenator::~Hyphenator() {}
 
+void Hyphenate::Hyphenator::setResultCache(ResultCache *c) {
+   cache = c;
+}
+
+auto_ptr<vector<const HyphenationRule*> >
+   Hyphenate::Hyphenator::apply_patterns(CFStringRef word, size_t node) const
+{
+   if (overlays[node])
+      return overlays[node]->applyPatterns(word);
+   return dictionaries[node]->applyPatterns(word);
+}
+
+/* The tree hyphenates the lowercased word, so that is the key under which
+ * results are cached. It is made the way the tree lowercases: ASCII right
+ * away, anything else through CoreFoundation. Returns false if lowercasing
+ * changes the length, as the positions would not match then. */
+static bool cache_key(const UniChar *word, CFIndex length, UniChar *key) {
+   CFCharacterSetRef upper =
+      CFCharacterSetGetPredefined(kCFCharacterSetUppercaseLetter);
+   bool other = false;
+   for (CFIndex i = 0; i < length; i++) {
+      UniChar c = word[i];
+      if (c >= 'A' && c <= 'Z')
+         c += 'a' - 'A';
+      else if (c >= 0x80 && !other)
+         other = (c >= 0xd800 && c <= 0xdfff) ||
+            CFCharacterSetIsCharacterMember(upper, c);
+      key[i] = c;
+   }
+   if (!other)
+      return true;
+
+   CFStringRef string = CFStringCreateWithCharactersNoCopy(kCFAllocatorDefault,
+      word, length, kCFAllocatorNull);
+   CFMutableStringRef lowerCaseString = CFStringCreateMutableCopy(kCFAllocatorDefault, length, string);
+   CFRelease(string);
+   CFStringLowercase(lowerCaseString, NULL);
+   bool same_length = CFStringGetLength(lowerCaseString) == length;
+   if (same_length)
+      CFStringGetCharacters(lowerCaseString, CFRangeMake(0, length), key);
+   CFRelease(lowerCaseString);
+   return same_length;
+}
+
+/* The result cache tells dictionaries apart by their pattern checksums. */
+UInt64 Hyphenate::Hyphenator::cache_dictionary(size_t node) const {
+   return overlays[node] ? overlays[node]->patternChecksum()
+      : dictionaries[node]->patternChecksum();
+}
+
+bool Hyphenate::Hyphenator::find_cached(const UniChar *key, CFIndex length,
+   size_t node, const HyphenationRule **rules) const
+{
+   UInt64 breaks;
+   if (!cache->find(cache_dictionary(node), key, length, breaks))
+      return false;
+   for (CFIndex i = 0; i < length; i++)
+      rules[i] = (breaks & (1ULL << i)) ? dictionaries[node]->rule(0) : NULL;
+   return true;
+}
+
+/* Only results made of standard rules fit into the cache. */
+void Hyphenate::Hyphenator::remember(const UniChar *key, CFIndex length,
+   size_t node, const HyphenationRule *const *rules) const
+{
+   UInt64 breaks = 0;
+   for (CFIndex i = 0; i < length; i++) {
+      if (!rules[i])
+         continue;
+      if (rules[i]->isNonStandard())
+         return;
+      breaks |= 1ULL << i;
+   }
+   cache->insert(cache_dictionary(node), key, length, breaks);
+}
+
 std::auto_ptr<std::vector<const HyphenationRule*> > 
    Hyphenate::Hyphenator::applyHyphenationRules(CFStringRef word)
 {
-   return dictionary->applyPatterns(word);
+   size_t node = local_node();
+   CFIndex length = CFStringGetLength(word);
+   if (!cache || length == 0 || length > ResultCache::max_word)
+      return apply_patterns(word, node);
+
+   UniChar characters[ResultCache::max_word], key[ResultCache::max_word];
+   CFStringGetCharacters(word, CFRangeMake(0, length), characters);
+   if (!cache_key(characters, length, key))
+      return apply_patterns(word, node);
+
+   auto_ptr<vector<const HyphenationRule*> > rules(
+      new vector<const HyphenationRule*>(length,
+         (const HyphenationRule*)NULL));
+   if (find_cached(key, length, node, &(*rules)[0]))
+      return rules;
+   rules = apply_patterns(word, node);
+   remember(key, length, node, &(*rules)[0]);
+   return rules;
+}
+
+std::auto_ptr<std::vector<const HyphenationRule*> > 
+   Hyphenate::Hyphenator::applyHyphenationRules(CFStringRef word, CFRange range)
+{
+   size_t node = local_node();
+   const OverlayDictionary *overlay = overlays[node];
+   if (!overlay)
+      return dictionaries[node]->applyPatterns(word, range);
+
+   /* Dialects are not windowed; cut the range out of the whole word. */
+   CFIndex length = CFStringGetLength(word);
+   CFIndex from = max((CFIndex)0, range.location);
+   CFIndex to = min(length, range.location + range.length);
+   auto_ptr<vector<const HyphenationRule*> > all = overlay->applyPatterns(word);
+   auto_ptr<vector<const HyphenationRule*> > rules(
+      new vector<const HyphenationRule*>(max((CFIndex)0, to - from),
+         (const HyphenationRule*)NULL));
+   if (from < to)
+      copy(all->begin() + from, all->begin() + to, rules->begin());
+   return rules;
+}
+
+void Hyphenate::Hyphenator::applyHyphenationRules(const UniChar *word,
+   CFIndex length, const HyphenationRule **rules, UInt8 *priorities) const
+{
+   size_t node = local_node();
+   UniChar key[ResultCache::max_word];
+   bool cached = cache && !priorities && length > 0
+      && length <= ResultCache::max_word && cache_key(word, length, key);
+   if (cached && find_cached(key, length, node, rules))
+      return;
+
+   if (overlays[node])
+      overlays[node]->applyPatterns(word, length, rules, priorities);
+   else
+      dictionaries[node]->applyPatterns(word, length, rules, priorities);
+   if (cached)
+      remember(key, length, node, rules);
 }
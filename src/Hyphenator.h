@@ -35,10 +35,39 @@
 namespace Hyphenate {
    class HyphenationTree;
    class HyphenationRule;
+   class DictionaryRegistry;
+   class NumaNodes;
+   class OverlayDictionary;
+   class PatternCatalog;
+   class ResultCache;
 
    class Hyphenator {
       private:
-	 std::auto_ptr<HyphenationTree> dictionary;
+         /* The tree is either owned or shared through a
+          * DictionaryRegistry. A dialect adds an overlay to it. If the
+          * registry copies its dictionaries for each NUMA node, there is
+          * a tree and an overlay per node, and each call uses those of
+          * the node it runs on. */
+	 std::auto_ptr<HyphenationTree> owned_dictionary;
+         std::vector<const HyphenationTree*> dictionaries;
+         std::vector<const OverlayDictionary*> overlays;
+         const NumaNodes *nodes;
+         ResultCache *cache;
+
+         size_t local_node() const;
+         UInt64 cache_dictionary(size_t node) const;
+         bool find_cached(const UniChar *key, CFIndex length, size_t node,
+            const HyphenationRule **rules) const;
+         void remember(const UniChar *key, CFIndex length, size_t node,
+            const HyphenationRule *const *rules) const;
+
+         void use_dictionary(const RFC_3066::Language& lang,
+            const PatternCatalog& catalog, DictionaryRegistry& registry);
+         std::auto_ptr<std::vector<const HyphenationRule*> >
+            apply_patterns(CFStringRef word, size_t node) const;
+
+         Hyphenator(const Hyphenator &);
+         Hyphenator &operator=(const Hyphenator &);
       public:
          /** Build a hyphenator for the given language. The hyphenation
           *  patterns for the language will loaded from a file named like
@@ -48,11 +77,34 @@ namespace Hyphenate {
           *  pattern directory which defaults to 
           *  /usr/local/share/libhyphenate-cfstring/patterns .
           *
+          *  The patterns are shared with all other Hyphenators whose
+          *  pattern files have the same contents, through
+          *  DictionaryRegistry::standard().
+          *
+          *  Throws a domain_error if no pattern file is found for the
+          *  language, or if the pattern directory is not set or cannot be
+          *  listed.
+          *
           * \param lang The language for which hyphenation patterns will be
           *             loaded. */
 	 Hyphenator(const RFC_3066::Language& lang); 
 
-         /** Build a hyphenator from the patterns in the file provided. */
+         /** Build a hyphenator for the given language, with the pattern
+          *  file chosen from the catalog given. */
+	 Hyphenator(const RFC_3066::Language& lang,
+            const PatternCatalog& catalog);
+
+         /** Build a hyphenator for the given language, sharing the
+          *  patterns through the given registry, which must outlive the
+          *  Hyphenator. If the registry keeps a copy of the patterns for
+          *  each NUMA node, each call to the Hyphenator uses the copy of
+          *  the node the calling thread runs on. */
+	 Hyphenator(const RFC_3066::Language& lang,
+            const PatternCatalog& catalog, DictionaryRegistry& registry);
+
+         /** Build a hyphenator from the patterns in the file provided,
+          *  which are not shared. Throws a domain_error if the file
+          *  cannot be read. */
 	 Hyphenator(const char *filename); 
 
          /** Destructor. */
@@ -65,6 +117,34 @@ namespace Hyphenate {
           *           entry for every hyphenation point. */
          std::auto_ptr<std::vector<const HyphenationRule*> > 
             applyHyphenationRules(CFStringRef word);
+
+         /** Look up and remember the results of applyHyphenationRules for
+          *  whole words in the given cache, which may be shared with other
+          *  Hyphenators and other processes. The cache is not owned and
+          *  must outlive the Hyphenator; NULL turns caching off.
+          *
+          *  The cache is used by applyHyphenationRules for CFStrings and
+          *  for UTF-16 characters when no priorities are asked for. It
+          *  keeps no priorities, so the ranged version, BreakIterator and
+          *  the C interface in hyphenate.h do not use it. */
+         void setResultCache(ResultCache *cache);
+
+         /** Like applyHyphenationRules, but only for the hyphenation points
+          *  before the letters in the given range of the word.
+          *
+          *  \returns A vector with the same size as the range. */
+         std::auto_ptr<std::vector<const HyphenationRule*> > 
+            applyHyphenationRules(CFStringRef word, CFRange range);
+
+         /** Like applyHyphenationRules, but for a word given as UTF-16
+          *  characters. The rule for the position before each letter is
+          *  written to rules, which must have room for length entries,
+          *  and, if priorities is given, the priority of each hyphen as
+          *  described for HyphenationTree::applyPatterns. The result cache
+          *  is only used when no priorities are asked for, as it keeps
+          *  none. */
+         void applyHyphenationRules(const UniChar *word, CFIndex length,
+            const HyphenationRule **rules, UInt8 *priorities = NULL) const;
    };
 }
 
@@ -51,7 +51,7 @@ Language::Language(string rfc_3066) throw(domain_error) {
 }
 
 bool Language::operator==(const Language &o) const throw() {
-   list<string>::const_iterator me = this->a.begin(), you = o.a.begin();
+   vector<string>::const_iterator me = this->a.begin(), you = o.a.begin();
 
    while (true) {
       if (me == this->a.end() || you == o.a.end())
@@ -64,7 +64,7 @@ bool Language::operator==(const Language &o) const throw() {
 }
 
 bool Language::operator<(const Language &o) const throw() {
-   list<string>::const_iterator me = this->a.begin(), you = o.a.begin();
+   vector<string>::const_iterator me = this->a.begin(), you = o.a.begin();
 
    while (true) {
       if (me == this->a.end() || you == o.a.end())
@@ -84,8 +84,10 @@ Language::operator string() const throw() {
 
 std::string Language::concat(int depth, const string& sep) const throw() {
    string accum;
-   for (list<string>::const_iterator i = a.begin(); i != a.end(); i++) {
-      accum += ((i == a.begin()) ? "" : sep) + *i;
+   for (vector<string>::const_iterator i = a.begin(); i != a.end(); i++) {
+      if (i != a.begin())
+	 accum += sep;
+      accum += *i;
       if (--depth <= 0) break;
    }
 
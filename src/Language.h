@@ -23,7 +23,7 @@
 #ifndef LANGUAGE_H
 #define LANGUAGE_H
 
-#include <list>
+#include <vector>
 #include <string>
 #include <stdexcept>
 
@@ -33,7 +33,7 @@ namespace RFC_3066 {
       private:
 	 /* This is a list of the components, all in lowercase; for example,
 	  * for de-AT the list would have the two elements "de" and "at". */
-	 std::list<std::string> a;
+	 std::vector<std::string> a;
 
       public:
 	 /** Construct from an RFC-3066-compliant string. */
@@ -43,6 +43,9 @@ namespace RFC_3066 {
 	 bool operator==(const Language &o) const throw();
 	 bool operator<(const Language &o) const throw();
 
+	 /** Returns the number of components, e.g. 2 for de-AT. */
+	 int subtags() const throw() { return a.size(); }
+
 	 /** Re-string to a RFC-3066-compliant string. */
 	 operator std::string() const throw();
 	 /** Concat only the first 'elements' elements of the language 
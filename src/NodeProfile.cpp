@@ -0,0 +1,86 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+/* ------------- Implementation for NodeProfile.h ---------------- */
+
+#include "NodeProfile.h"
+#include <sstream>
+#include <stdexcept>
+#include <stdlib.h>
+
+using namespace std;
+using namespace Hyphenate;
+
+void Hyphenate::NodeProfile::add(const string &path, unsigned long visits) {
+   if (visits)
+      counts[path] += visits;
+}
+
+unsigned long Hyphenate::NodeProfile::visits(const string &path) const {
+   map<string, unsigned long>::const_iterator i = counts.find(path);
+   return (i == counts.end()) ? 0 : i->second;
+}
+
+void Hyphenate::NodeProfile::load(istream &source) {
+   string line;
+   while (getline(source, line)) {
+      if (line.empty())
+         continue;
+      if (line[0] == '#') {
+         istringstream fields(line.substr(1));
+         string name;
+         UInt64 checksum;
+         if (!(fields >> name) || name != "patterns")
+            continue;
+         if (!(fields >> hex >> checksum))
+            throw domain_error("libhyphenate-cfstring: Malformed line in "
+               "node profile: " + line);
+         if (pattern_checksum && checksum != pattern_checksum)
+            throw domain_error("libhyphenate-cfstring: Node profile was "
+               "made for other patterns");
+         pattern_checksum = checksum;
+         continue;
+      }
+      string::size_type tab = line.find('\t');
+      char *end;
+      unsigned long visits = strtoul(line.c_str(), &end, 10);
+      if (tab == string::npos || end != line.c_str() + tab)
+         throw domain_error("libhyphenate-cfstring: Malformed line in "
+            "node profile: " + line);
+      add(line.substr(tab + 1), visits);
+   }
+}
+
+void Hyphenate::NodeProfile::save(ostream &destination) const {
+   if (pattern_checksum) {
+      ios::fmtflags flags = destination.flags();
+      destination << "# patterns " << hex << pattern_checksum << '\n';
+      destination.flags(flags);
+   }
+   for (map<string, unsigned long>::const_iterator i = counts.begin();
+         i != counts.end(); i++)
+      destination << i->second << '\t' << i->first << '\n';
+}
+
+string Hyphenate::NodeProfile::pathFor(const string &patterns) {
+   return patterns + ".profile";
+}
@@ -0,0 +1,84 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+#ifndef HYPHENATE_NODE_PROFILE_H
+#define HYPHENATE_NODE_PROFILE_H
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <CoreFoundation/CoreFoundation.h>
+
+namespace Hyphenate {
+   /** A NodeProfile counts how often each node of a HyphenationTree is
+    *  visited while a sample of text is hyphenated; see
+    *  HyphenationTree::profile. HyphenationTree::optimizeLayout uses it to
+    *  place the most visited nodes next to each other in memory.
+    *
+    *  A node is identified by the (lowercase) letters leading to it from
+    *  the root, so a profile can be saved and applied to a tree loaded
+    *  later from the same patterns. The profile records the checksum of
+    *  those patterns, so that it is not applied to others. Hyphenator
+    *  picks up a profile that is saved next to its pattern file, under the
+    *  name given by pathFor. */
+   class NodeProfile {
+      private:
+         std::map<std::string, unsigned long> counts;
+         UInt64 pattern_checksum;
+
+      public:
+         NodeProfile() : pattern_checksum(0) {}
+
+         /** Add visits to the count of the node reached by path, which
+          *  is UTF-8. */
+         void add(const std::string &path, unsigned long visits);
+
+         /** The number of visits of the node reached by path. */
+         unsigned long visits(const std::string &path) const;
+
+         /** The number of nodes with visits. */
+         size_t size() const { return counts.size(); }
+
+         /** The checksum of the patterns the visits were counted with
+          *  (see HyphenationTree::patternChecksum), or 0 if unknown. */
+         UInt64 patternChecksum() const { return pattern_checksum; }
+
+         /** Set the checksum of the patterns the visits are counted with. */
+         void setPatternChecksum(UInt64 checksum)
+            { pattern_checksum = checksum; }
+
+         /** Read a profile written by save, adding its counts to this
+          *  one. Throws a domain_error if a line is malformed, or if both
+          *  profiles know their patterns and they are not the same. */
+         void load(std::istream &source);
+
+         /** Write the profile: a line "# patterns" with the checksum of
+          *  the patterns in hexadecimal, then one node per line: the
+          *  number of visits, a tab and the path of the node. */
+         void save(std::ostream &destination) const;
+
+         /** The name of the profile for the given pattern file. */
+         static std::string pathFor(const std::string &patterns);
+   };
+}
+
+#endif
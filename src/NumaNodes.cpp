@@ -0,0 +1,183 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+/* ------------- Implementation for NumaNodes.h ---------------- */
+
+#include "NumaNodes.h"
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <stdlib.h>
+#include <dirent.h>
+#include <pthread.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+using namespace std;
+using namespace Hyphenate;
+
+/* Parse a sysfs cpu list such as "0-3,8-11". */
+static vector<int> parse_cpu_list(const string &list) {
+   vector<int> cpus;
+   const char *p = list.c_str();
+   while (*p >= '0' && *p <= '9') {
+      char *rest;
+      long first = strtol(p, &rest, 10), last = first;
+      if (*rest == '-')
+         last = strtol(rest + 1, &rest, 10);
+      for (long cpu = first; cpu <= last; cpu++)
+         cpus.push_back(cpu);
+      p = (*rest == ',') ? rest + 1 : rest;
+   }
+   return cpus;
+}
+
+Hyphenate::NumaNodes::NumaNodes(const string &directory) {
+#ifdef __linux__
+   map<long, vector<int> > nodes;
+   DIR *d = opendir(directory.c_str());
+   if (d) {
+      struct dirent *e;
+      while ((e = readdir(d)) != NULL) {
+         string name = e->d_name;
+         if (name.compare(0, 4, "node") != 0 || name.size() == 4 ||
+               name.find_first_not_of("0123456789", 4) != string::npos)
+            continue;
+         ifstream list((directory + "/" + name + "/cpulist").c_str());
+         string line;
+         getline(list, line);
+         /* Nodes without processors hold only memory; no thread will
+          * ever ask for them. */
+         vector<int> cpus = parse_cpu_list(line);
+         if (!cpus.empty())
+            nodes[atol(name.c_str() + 4)] = cpus;
+      }
+      closedir(d);
+   }
+
+   if (nodes.size() > 1) {
+      for (map<long, vector<int> >::iterator i = nodes.begin();
+            i != nodes.end(); i++) {
+         for (size_t c = 0; c < i->second.size(); c++) {
+            size_t cpu = i->second[c];
+            if (cpu >= cpu_nodes.size())
+               cpu_nodes.resize(cpu + 1, 0);
+            cpu_nodes[cpu] = node_cpus.size();
+         }
+         node_cpus.push_back(i->second);
+      }
+      return;
+   }
+#endif
+
+   /* A single node holds all processors. */
+   node_cpus.push_back(vector<int>());
+}
+
+const NumaNodes &Hyphenate::NumaNodes::system() {
+   /* Never deleted, like DictionaryRegistry::standard. */
+   static pthread_mutex_t system_lock = PTHREAD_MUTEX_INITIALIZER;
+   static NumaNodes *nodes = NULL;
+
+   pthread_mutex_lock(&system_lock);
+   if (!nodes)
+      nodes = new NumaNodes();
+   pthread_mutex_unlock(&system_lock);
+   return *nodes;
+}
+
+#ifdef __linux__
+/* The node the calling thread found last, the topology it was found in,
+ * and how many more calls may be answered from it. */
+static __thread const NumaNodes *cached_nodes = NULL;
+static __thread size_t cached_node = 0;
+static __thread unsigned cached_calls = 0;
+#endif
+
+size_t Hyphenate::NumaNodes::current() const {
+   if (node_cpus.size() == 1)
+      return 0;
+#ifdef __linux__
+   if (cached_nodes == this && cached_calls > 0) {
+      cached_calls--;
+      return cached_node;
+   }
+   int cpu = sched_getcpu();
+   cached_node = (cpu >= 0 && (size_t)cpu < cpu_nodes.size())
+      ? cpu_nodes[cpu] : 0;
+   cached_nodes = this;
+   cached_calls = REFRESH_INTERVAL - 1;
+   return cached_node;
+#else
+   return 0;
+#endif
+}
+
+/* A job and the node to run it on. */
+struct NodeTask {
+   NumaNodes::Job *job;
+   size_t node;
+};
+
+void *Hyphenate::NumaNodes::run_thread(void *task) {
+   NodeTask *t = static_cast<NodeTask *>(task);
+   t->job->run(t->node);
+   return NULL;
+}
+
+void Hyphenate::NumaNodes::runOnEach(Job &job) const {
+   if (node_cpus.size() == 1) {
+      job.run(0);
+      return;
+   }
+
+   vector<NodeTask> tasks(node_cpus.size());
+   vector<pthread_t> thread_ids(node_cpus.size());
+   vector<bool> started(node_cpus.size(), false);
+   for (size_t n = 0; n < node_cpus.size(); n++) {
+      tasks[n].job = &job;
+      tasks[n].node = n;
+      pthread_attr_t attributes;
+      pthread_attr_init(&attributes);
+#ifdef __linux__
+      cpu_set_t cpus;
+      CPU_ZERO(&cpus);
+      for (size_t c = 0; c < node_cpus[n].size(); c++)
+         if (node_cpus[n][c] < CPU_SETSIZE)
+            CPU_SET(node_cpus[n][c], &cpus);
+      pthread_attr_setaffinity_np(&attributes, sizeof(cpus), &cpus);
+#endif
+      started[n] = pthread_create(&thread_ids[n], &attributes,
+         &NumaNodes::run_thread, &tasks[n]) == 0;
+      pthread_attr_destroy(&attributes);
+   }
+
+   /* The calling thread takes over the nodes whose thread could not be
+    * started; the job is done, if not in the best place. */
+   for (size_t n = 0; n < node_cpus.size(); n++)
+      if (!started[n])
+         job.run(n);
+   for (size_t n = 0; n < node_cpus.size(); n++)
+      if (started[n])
+         pthread_join(thread_ids[n], NULL);
+}
@@ -0,0 +1,87 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+#ifndef HYPHENATE_NUMA_NODES_H
+#define HYPHENATE_NUMA_NODES_H
+
+#include <string>
+#include <vector>
+
+namespace Hyphenate {
+   /** The NUMA nodes of the machine: groups of processors that share a
+    *  memory controller, and reach the memory of other nodes only through
+    *  the slower interconnect. DictionaryRegistry uses them to keep one
+    *  copy of each dictionary in the memory of each node.
+    *
+    *  The topology is read from Linux' sysfs. Elsewhere, and on machines
+    *  without NUMA, there is a single node holding all processors. */
+   class NumaNodes {
+      public:
+         /** Work to be done once on each node. */
+         class Job {
+            public:
+               virtual ~Job() {}
+               virtual void run(size_t node) = 0;
+         };
+
+         /** Read the topology from the given sysfs directory, which holds
+          *  a subdirectory nodeN with a cpulist file for each node. */
+         NumaNodes(const std::string &directory = "/sys/devices/system/node");
+
+         /** Returns the topology of this machine, read once. */
+         static const NumaNodes &system();
+
+         /** The number of nodes, at least 1. Nodes are numbered from 0 in
+          *  the order of their ids, which need not be contiguous. */
+         size_t count() const { return node_cpus.size(); }
+
+         /** The node of the processor the calling thread is running on.
+          *  The thread may be moved to another node at any time, so this
+          *  is a hint: each thread asks the kernel only on every
+          *  REFRESH_INTERVAL'th call and answers the others from what it
+          *  was told last. Returns 0 if it cannot be told. */
+         size_t current() const;
+
+         /** Run the job once for each node, on a thread bound to the
+          *  processors of that node, and wait for all of them. Memory that
+          *  the job allocates and first writes to is then, by the kernel's
+          *  default policy, placed on that node. With a single node, the
+          *  job is run on the calling thread. */
+         void runOnEach(Job &job) const;
+
+         /** How many calls to current() a thread answers from the node it
+          *  looked up last. */
+         static const unsigned REFRESH_INTERVAL = 256;
+
+      private:
+         /* The processors of each node, and the node of each processor. */
+         std::vector<std::vector<int> > node_cpus;
+         std::vector<size_t> cpu_nodes;
+
+         static void *run_thread(void *task);
+
+         NumaNodes(const NumaNodes &);
+         NumaNodes &operator=(const NumaNodes &);
+   };
+}
+
+#endif
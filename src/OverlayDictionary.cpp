@@ -0,0 +1,86 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+/* ------------- Implementation for OverlayDictionary.h ---------------- */
+
+#include "OverlayDictionary.h"
+#include "HyphenationRule.h"
+#include "Checksum.h"
+
+using namespace std;
+using namespace Hyphenate;
+
+Hyphenate::OverlayDictionary::OverlayDictionary(const HyphenationTree &base)
+: base_tree(base)
+{
+}
+
+void Hyphenate::OverlayDictionary::loadPatterns(istream &i) {
+   overlay.loadPatterns(i);
+}
+
+void Hyphenate::OverlayDictionary::insert(auto_ptr<HyphenationRule> pattern)
+{
+   overlay.insert(pattern);
+}
+
+UInt64 Hyphenate::OverlayDictionary::patternChecksum() const {
+   UInt64 overlay_checksum = overlay.patternChecksum();
+   return checksum(&overlay_checksum, sizeof(overlay_checksum),
+      base_tree.patternChecksum());
+}
+
+int Hyphenate::OverlayDictionary::ruleId(const HyphenationRule *r) const {
+   int id = base_tree.ruleId(r);
+   if (id >= 0)
+      return id;
+   id = overlay.ruleId(r);
+   if (id <= 0)
+      return id;
+   return base_tree.nonstandard_rules.size() + id;
+}
+
+const HyphenationRule *Hyphenate::OverlayDictionary::rule(int id) const {
+   int base_rules = base_tree.nonstandard_rules.size();
+   if (id <= base_rules)
+      return base_tree.rule(id);
+   return overlay.rule(id - base_rules);
+}
+
+auto_ptr<vector<const HyphenationRule*> >
+   Hyphenate::OverlayDictionary::applyPatterns(CFStringRef word) const
+{
+   return base_tree.apply_patterns(word, INT_MAX, &overlay, NULL);
+}
+
+auto_ptr<vector<const HyphenationRule*> >
+   Hyphenate::OverlayDictionary::applyPatterns(CFStringRef word,
+      CFIndex stop_at) const
+{
+   return base_tree.apply_patterns(word, stop_at, &overlay, NULL);
+}
+
+void Hyphenate::OverlayDictionary::applyPatterns(const UniChar *word,
+   CFIndex length, const HyphenationRule **output, UInt8 *priorities) const
+{
+   base_tree.apply_patterns(word, length, output, priorities, &overlay);
+}
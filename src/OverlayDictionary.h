@@ -0,0 +1,100 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+#ifndef HYPHENATE_OVERLAY_DICTIONARY_H
+#define HYPHENATE_OVERLAY_DICTIONARY_H
+
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <CoreFoundation/CoreFoundation.h>
+#include "HyphenationTree.h"
+
+namespace Hyphenate {
+   class HyphenationRule;
+
+   /** An OverlayDictionary adds a few patterns of its own to a shared base
+    *  HyphenationTree without copying it. Both are consulted together, and
+    *  the result is the same as if the overlay's patterns had been
+    *  inserted into a copy of the base: a pattern in the overlay replaces
+    *  the base's pattern for the same letters. A pattern without any
+    *  digits therefore removes the base's pattern.
+    *
+    *  Many overlays can share one base. The base must outlive them and
+    *  must not be modified while they are in use. The safe areas at the
+    *  start and end of words are always those of the base. */
+   class OverlayDictionary {
+      private:
+         const HyphenationTree &base_tree;
+         HyphenationTree overlay;
+
+         OverlayDictionary(const OverlayDictionary &);
+         OverlayDictionary &operator=(const OverlayDictionary &);
+
+      public:
+         /** Construct an empty overlay over the given base. */
+         OverlayDictionary(const HyphenationTree &base);
+
+         /** Read patterns into the overlay, as HyphenationTree::loadPatterns
+          *  does. */
+         void loadPatterns(std::istream &source);
+
+         /** Insert a pattern into the overlay. */
+         void insert(std::auto_ptr<HyphenationRule> pattern);
+
+         /** A checksum of the base's and the overlay's patterns; see
+          *  HyphenationTree::patternChecksum. */
+         UInt64 patternChecksum() const;
+
+         /** Returns a number identifying the rule, like
+          *  HyphenationTree::ruleId: 0 for the standard rule of either
+          *  tree, then the base's non-standard rules, then the overlay's.
+          *  NULL and rules of other trees have the number -1. */
+         int ruleId(const HyphenationRule *rule) const;
+
+         /** Returns the rule with the given number, or NULL if there is
+          *  none. */
+         const HyphenationRule *rule(int id) const;
+
+         /** The shared base tree. */
+         const HyphenationTree &base() const { return base_tree; }
+
+         /** Apply the patterns of base and overlay to the word, as
+          *  HyphenationTree::applyPatterns does. The pointers in the vector
+          *  point into either tree. */
+         std::auto_ptr<std::vector<const HyphenationRule*> > applyPatterns
+               (CFStringRef word) const; 
+
+         /** Like applyPattern, but will only hyphenate up to the letter
+          *  end_at. */
+         std::auto_ptr<std::vector<const HyphenationRule*> > applyPatterns
+               (CFStringRef word, CFIndex end_at) const; 
+
+         /** Like applyPattern, but for UTF-16 characters, as
+          *  HyphenationTree::applyPatterns does. */
+         void applyPatterns(const UniChar *word, CFIndex length,
+               const HyphenationRule **output,
+               UInt8 *priorities = NULL) const;
+   };
+}
+
+#endif
@@ -0,0 +1,272 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+/* ------------- Implementation for PatternCatalog.h ---------------- */
+
+#include "PatternCatalog.h"
+#include "Checksum.h"
+#include "NodeProfile.h"
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <ctype.h>
+#include <stdlib.h>
+#include <dirent.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace RFC_3066;
+using namespace Hyphenate;
+
+/* Aliases are followed at most this often, which guards against cycles. */
+#define MAX_ALIAS_DEPTH 8
+
+static string lowercase(const string &s) {
+   string lower(s);
+   for (string::iterator i = lower.begin(); i != lower.end(); i++)
+      *i = tolower(*i);
+   return lower;
+}
+
+Hyphenate::PatternCatalog::PatternCatalog(const string &directory)
+: dir(directory)
+{
+   /* An empty path must not become the root directory. */
+   if (dir.empty())
+      throw domain_error("libhyphenate-cfstring: No pattern directory "
+         "given; set LIBHYPHENATE_PATH");
+   if (dir[dir.size() - 1] != '/')
+      dir += "/";
+
+   struct stat buf;
+   string index = dir + "index";
+   if (stat(index.c_str(), &buf) != -1)
+      read_index(index);
+   else
+      scan_directory();
+}
+
+const PatternCatalog &Hyphenate::PatternCatalog::standard() {
+   string path = "";
+
+   if (getenv("LIBHYPHENATE_PATH")) {
+      path = getenv("LIBHYPHENATE_PATH");
+   }
+
+#ifdef LIBHYPHENATE_DEFAULT_PATH
+   if (path == "")
+      path = LIBHYPHENATE_DEFAULT_PATH;
+#endif
+
+   return shared(path);
+}
+
+const PatternCatalog &Hyphenate::PatternCatalog::shared(const string &directory)
+{
+   /* The catalogs are never deleted, so that references to them stay
+    * valid for the lifetime of the process. */
+   static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+   static map<string, PatternCatalog*> catalogs;
+
+   pthread_mutex_lock(&lock);
+   map<string, PatternCatalog*>::iterator i = catalogs.find(directory);
+   if (i == catalogs.end()) {
+      try {
+         i = catalogs.insert(
+            make_pair(directory, new PatternCatalog(directory))).first;
+      } catch (...) {
+         pthread_mutex_unlock(&lock);
+         throw;
+      }
+   }
+   pthread_mutex_unlock(&lock);
+
+   return *i->second;
+}
+
+void Hyphenate::PatternCatalog::read_index(const string &index) {
+   ifstream i(index.c_str());
+   if (!i)
+      throw domain_error("libhyphenate-cfstring: Cannot read " + index);
+
+   string line;
+   while (getline(i, line)) {
+      string::size_type comment = line.find('#');
+      if (comment != string::npos)
+         line.erase(comment);
+
+      istringstream fields(line);
+      string tag, file, target, base;
+      if (!(fields >> tag))
+         continue;
+      if (!(fields >> file))
+         throw domain_error("libhyphenate-cfstring: No pattern file given "
+            "for " + tag + " in " + index);
+
+      if (file == "=") {
+         if (!(fields >> target))
+            throw domain_error("libhyphenate-cfstring: No alias target "
+               "given for " + tag + " in " + index);
+         addAlias(tag, target);
+      } else {
+         fields >> base;
+         add_entry(lowercase(tag), (file[0] == '/') ? file : dir + file,
+            lowercase(base));
+      }
+   }
+}
+
+void Hyphenate::PatternCatalog::scan_directory() {
+   DIR *d = opendir(dir.c_str());
+   if (!d)
+      throw domain_error("libhyphenate-cfstring: Cannot read pattern "
+         "directory " + dir);
+
+   /* Symbolic links are remembered until all files are known, since
+    * readdir returns the links and their targets in any order. */
+   vector<pair<string, string> > links;
+
+   /* Node profiles accompany pattern files; they are not patterns. */
+   const string profile_suffix = NodeProfile::pathFor("");
+
+   struct dirent *e;
+   while ((e = readdir(d)) != NULL) {
+      string name = e->d_name;
+      if (name[0] == '.' || name == "index")
+         continue;
+      if (name.size() > profile_suffix.size() &&
+            name.compare(name.size() - profile_suffix.size(),
+               profile_suffix.size(), profile_suffix) == 0)
+         continue;
+
+      string path = dir + name;
+      struct stat buf;
+      if (lstat(path.c_str(), &buf) == -1)
+         continue;
+
+      if (S_ISLNK(buf.st_mode)) {
+         char target[PATH_MAX];
+         ssize_t length = readlink(path.c_str(), target, sizeof(target) - 1);
+         if (length > 0) {
+            target[length] = 0;
+            links.push_back(make_pair(name, string(target)));
+         }
+      } else if (S_ISREG(buf.st_mode))
+         add_entry(lowercase(name), path);
+   }
+   closedir(d);
+
+   for (vector<pair<string, string> >::iterator l = links.begin();
+         l != links.end(); l++) {
+      string target = lowercase(l->second);
+      if (target.find('/') == string::npos && entry_map.count(target)) {
+         addAlias(l->first, target);
+      } else {
+         /* A link leading out of the directory is a file of its own. */
+         struct stat buf;
+         string path = dir + l->first;
+         if (stat(path.c_str(), &buf) != -1 && S_ISREG(buf.st_mode))
+            add_entry(lowercase(l->first), path);
+      }
+   }
+}
+
+void Hyphenate::PatternCatalog::add_entry(const string &tag,
+   const string &path, const string &base)
+{
+   struct stat buf;
+   if (stat(path.c_str(), &buf) == -1)
+      throw domain_error("libhyphenate-cfstring: Cannot read pattern file "
+         + path);
+
+   Entry entry;
+   entry.tag = tag;
+   entry.path = path;
+   entry.size = buf.st_size;
+   entry.base = base;
+   entry_map[tag] = entry;
+}
+
+/* Catalogs are shared between threads, so the checksums are computed under
+ * a lock. */
+static pthread_mutex_t checksum_lock = PTHREAD_MUTEX_INITIALIZER;
+
+UInt64 Hyphenate::PatternCatalog::Entry::checksum() const {
+   pthread_mutex_lock(&checksum_lock);
+   if (!checksummed) {
+      ifstream i(path.c_str(), ios::in | ios::binary);
+      if (!i) {
+         pthread_mutex_unlock(&checksum_lock);
+         throw domain_error("libhyphenate-cfstring: Cannot read pattern "
+            "file " + path);
+      }
+
+      UInt64 sum = checksum_seed;
+      char buffer[4096];
+      while (i.read(buffer, sizeof(buffer)) || i.gcount())
+         sum = Hyphenate::checksum(buffer, i.gcount(), sum);
+      checksum_value = sum;
+      checksummed = true;
+   }
+   UInt64 sum = checksum_value;
+   pthread_mutex_unlock(&checksum_lock);
+   return sum;
+}
+
+void Hyphenate::PatternCatalog::addAlias(const string &alias,
+   const string &tag)
+{
+   alias_map[lowercase(alias)] = lowercase(tag);
+}
+
+const PatternCatalog::Entry *Hyphenate::PatternCatalog::find(
+   const string &tag) const
+{
+   string t = lowercase(tag);
+   for (int depth = 0; depth <= MAX_ALIAS_DEPTH; depth++) {
+      EntryMap::const_iterator e = entry_map.find(t);
+      if (e != entry_map.end())
+         return &e->second;
+
+      AliasMap::const_iterator a = alias_map.find(t);
+      if (a == alias_map.end())
+         return NULL;
+      t = a->second;
+   }
+   return NULL;
+}
+
+const PatternCatalog::Entry &Hyphenate::PatternCatalog::resolve(
+   const Language &lang) const
+{
+   for (int i = lang.subtags(); i > 0; i--) {
+      const Entry *e = find(lang.concat(i));
+      if (e)
+         return *e;
+   }
+
+   throw domain_error("libhyphenate-cfstring: No suitable hyphenation file "
+      "for language " + lang.concat(lang.subtags()) + " found in " + dir);
+}
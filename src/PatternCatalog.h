@@ -0,0 +1,134 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+#ifndef HYPHENATE_PATTERN_CATALOG_H
+#define HYPHENATE_PATTERN_CATALOG_H
+
+#include "Language.h"
+#include <map>
+#include <string>
+#include <stdexcept>
+#include <sys/types.h>
+#include <CoreFoundation/CoreFoundation.h>
+
+namespace Hyphenate {
+   /** The PatternCatalog knows which pattern files exist in a pattern
+    *  directory. The directory is examined once, on construction, so that
+    *  resolving a language to a file is a lookup in memory.
+    *
+    *  If the directory contains a file called "index", the catalog is read
+    *  from it. Each of its lines gives a language tag and the name of its
+    *  pattern file, relative to the directory, or a language tag, a '=' and
+    *  the tag it is an alias for:
+    *
+    *  de-ch de
+    *  de-de-1901 = de-1901
+    *
+    *  A third field names the tag of a base language, which makes the file
+    *  a dialect that only lists the differences to the base's patterns;
+    *  see DictionaryRegistry:
+    *
+    *  de-at de-at.delta de
+    *
+    *  Otherwise, each file in the directory is a pattern file named like
+    *  its language tag, and each symbolic link to another pattern file
+    *  is an alias. Tags are matched case-insensitively. */
+   class PatternCatalog {
+      public:
+         /** A single pattern file. */
+         struct Entry {
+            /** The language tag, in lowercase. */
+            std::string tag;
+            /** The full path to the pattern file. */
+            std::string path;
+            /** The size of the pattern file in bytes. */
+            off_t size;
+            /** For a dialect, the tag of the language whose patterns the
+             *  file amends, in lowercase; empty otherwise. */
+            std::string base;
+
+            /** The checksum of the file's contents; see Checksum.h. The
+             *  file is read on the first call, so that building a catalog
+             *  does not read every pattern file. Throws a domain_error if
+             *  the file cannot be read. */
+            UInt64 checksum() const;
+
+            Entry() : size(0), checksum_value(0), checksummed(false) {}
+
+            private:
+               mutable UInt64 checksum_value;
+               mutable bool checksummed;
+         };
+         typedef std::map<std::string, Entry> EntryMap;
+         typedef std::map<std::string, std::string> AliasMap;
+
+         /** Build the catalog for the given directory. Throws a domain_error
+          *  if the directory is empty or it or its index cannot be read. */
+         PatternCatalog(const std::string &directory);
+
+         /** Returns the catalog for the default pattern directory, which
+          *  is given by the environment variable LIBHYPHENATE_PATH or, if
+          *  this is empty, the compiled-in pattern directory. The catalog
+          *  is built on first use and shared afterwards. Throws a
+          *  domain_error if there is no such directory or it cannot be
+          *  read. */
+         static const PatternCatalog &standard();
+
+         /** Returns the shared catalog for the given directory, building
+          *  it on first use. */
+         static const PatternCatalog &shared(const std::string &directory);
+
+         /** Find the entry for the longest prefix of the language that has
+          *  a pattern file or an alias, just like
+          *  Language::find_suitable_file. Throws a domain_error if there
+          *  is none. */
+         const Entry &resolve(const RFC_3066::Language &lang) const;
+
+         /** Find the entry for exactly the given tag, following aliases.
+          *  Returns NULL if there is none. */
+         const Entry *find(const std::string &tag) const;
+
+         /** Make alias resolve to the same pattern file as tag. */
+         void addAlias(const std::string &alias, const std::string &tag);
+
+         /** The directory this catalog was built from, /-postfixed. */
+         const std::string &directory() const { return dir; }
+
+         /** All pattern files, by tag. */
+         const EntryMap &entries() const { return entry_map; }
+
+         /** All aliases, mapping to the tag they stand for. */
+         const AliasMap &aliases() const { return alias_map; }
+
+      private:
+         std::string dir;
+         EntryMap entry_map;
+         AliasMap alias_map;
+
+         void read_index(const std::string &index);
+         void scan_directory();
+         void add_entry(const std::string &tag, const std::string &path,
+            const std::string &base = std::string());
+   };
+}
+
+#endif
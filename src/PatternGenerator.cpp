@@ -0,0 +1,498 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+/* ------------- Implementation for PatternGenerator.h ---------------- */
+
+#include "PatternGenerator.h"
+#include "Checksum.h"
+#include "HyphenationRule.h"
+#include <algorithm>
+#include <string>
+#include <stdexcept>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+
+using namespace std;
+using namespace Hyphenate;
+
+typedef vector<UniChar> Key;
+typedef map<Key, vector<char> > PatternMap;
+
+namespace {
+   /* The good and bad counts of the pattern candidates of one length. A
+    * candidate is a letter sequence and the position of the hyphenation
+    * value within it, from 0 to length. The sequences are kept in a hash
+    * table and not copied: each entry points to the first place in the
+    * word list they were seen at, which stays put while a level is
+    * generated. */
+   class CandidateTable {
+      public:
+         struct Entry {
+            const UniChar *letters;
+            UInt64 hash;
+            /* The index of the entry's first count in counts. */
+            size_t counts;
+         };
+
+      private:
+         int length;
+         vector<Entry> entries;
+         /* Indices into entries, plus one; 0 is an empty bucket. */
+         vector<size_t> buckets;
+         /* The good and bad count for each position of each entry. */
+         vector<unsigned long> counts;
+
+         size_t &bucket(const UniChar *letters, UInt64 hash) {
+            size_t mask = buckets.size() - 1;
+            for (size_t b = hash & mask; ; b = (b + 1) & mask) {
+               if (!buckets[b])
+                  return buckets[b];
+               const Entry &e = entries[buckets[b] - 1];
+               if (e.hash == hash &&
+                     equal(letters, letters + length, e.letters))
+                  return buckets[b];
+            }
+         }
+
+         void grow() {
+            vector<size_t> old(buckets.size() * 2, 0);
+            old.swap(buckets);
+            for (size_t e = 0; e < entries.size(); e++)
+               bucket(entries[e].letters, entries[e].hash) = e + 1;
+         }
+
+      public:
+         CandidateTable() : length(0), buckets(1024, 0) {}
+
+         void setLength(int l) { length = l; }
+
+         /* Add to the counts of the candidate at dot within letters. */
+         void add(const UniChar *letters, int dot, unsigned long good,
+            unsigned long bad)
+         {
+            UInt64 hash = checksum(letters, length * sizeof(UniChar));
+            size_t &b = bucket(letters, hash);
+            if (!b) {
+               Entry e = { letters, hash, counts.size() };
+               entries.push_back(e);
+               counts.resize(counts.size() + 2 * (length + 1), 0);
+               b = entries.size();
+               if (entries.size() * 2 > buckets.size())
+                  grow();
+            }
+            unsigned long *c = &counts[entries[b - 1].counts + 2 * dot];
+            c[0] += good;
+            c[1] += bad;
+         }
+
+         /* Add all counts of the other table to this one. */
+         void merge(const CandidateTable &other) {
+            for (size_t e = 0; e < other.entries.size(); e++)
+               for (int dot = 0; dot <= length; dot++) {
+                  const unsigned long *c =
+                     &other.counts[other.entries[e].counts + 2 * dot];
+                  if (c[0] || c[1])
+                     add(other.entries[e].letters, dot, c[0], c[1]);
+               }
+         }
+
+         const vector<Entry> &all() const { return entries; }
+         unsigned long good(const Entry &e, int dot) const
+            { return counts[e.counts + 2 * dot]; }
+         unsigned long bad(const Entry &e, int dot) const
+            { return counts[e.counts + 2 * dot + 1]; }
+   };
+
+   /* A read-only trie over the patterns of a PatternGenerator. It is
+    * rebuilt before each pass over the word list so that all counting
+    * threads can match against it without locking. */
+   class PatternIndex {
+      private:
+         struct Node {
+            map<UniChar, size_t> next;
+            const vector<char> *values;
+            Node() : values(NULL) {}
+         };
+         vector<Node> nodes;
+
+      public:
+         PatternIndex(const PatternMap &patterns) : nodes(1) {
+            for (PatternMap::const_iterator p = patterns.begin();
+                  p != patterns.end(); p++) {
+               size_t n = 0;
+               for (Key::const_iterator c = p->first.begin();
+                     c != p->first.end(); c++) {
+                  map<UniChar, size_t>::iterator i = nodes[n].next.find(*c);
+                  if (i == nodes[n].next.end()) {
+                     nodes[n].next.insert(make_pair(*c, nodes.size()));
+                     n = nodes.size();
+                     nodes.push_back(Node());
+                  } else
+                     n = i->second;
+               }
+               nodes[n].values = &p->second;
+            }
+         }
+
+         /* Compute the hyphenation values of a dotted word. The value at
+          * index i is for the position before letters[i]. */
+         void hyphenate(const Key &letters, vector<char> &values) const {
+            values.assign(letters.size() + 1, 0);
+            for (size_t i = 0; i < letters.size(); i++) {
+               size_t n = 0;
+               for (size_t j = i; j < letters.size(); j++) {
+                  map<UniChar, size_t>::const_iterator next =
+                     nodes[n].next.find(letters[j]);
+                  if (next == nodes[n].next.end())
+                     break;
+                  n = next->second;
+                  const vector<char> *v = nodes[n].values;
+                  if (v)
+                     for (size_t o = 0; o < v->size(); o++)
+                        if (values[i + o] < (*v)[o])
+                           values[i + o] = (*v)[o];
+               }
+            }
+         }
+   };
+}
+
+/* A PatternGeneratorJob processes a slice of the word list on its own
+ * thread. Depending on the level, it either counts pattern candidates or
+ * (for level 0) just gathers statistics. */
+class Hyphenate::PatternGeneratorJob {
+   public:
+      const PatternGenerator *generator;
+      const PatternIndex *index;
+      size_t begin, end;
+      int level, length;
+
+      CandidateTable candidates;
+      PatternGenerator::Statistics statistics;
+
+      void run() {
+         vector<char> values;
+         for (size_t w = begin; w < end; w++) {
+            const PatternGenerator::Word &word = generator->words[w];
+            index->hyphenate(word.letters, values);
+
+            /* We honor the safe areas at the start and end of each word
+             * just like HyphenationTree::applyPatterns does. */
+            int size = word.letters.size();
+            for (int p = 1 + generator->start_safe;
+                  p <= size - 1 - generator->end_safe; p++) {
+               bool hyphen = word.hyphens[p];
+               if (level == 0) {
+                  if (values[p] % 2 == 1)
+                     (hyphen ? statistics.good : statistics.bad)++;
+                  else if (hyphen)
+                     statistics.missed++;
+                  continue;
+               }
+
+               /* Odd levels may only turn even values into hyphens, even
+                * levels may only suppress odd values. */
+               if (values[p] >= level || values[p] % 2 == level % 2)
+                  continue;
+               bool good = (level % 2 == 1) ? hyphen : !hyphen;
+
+               for (int dot = 0; dot <= length; dot++) {
+                  int start = p - dot;
+                  if (start < 0 || start + length > size)
+                     continue;
+                  candidates.add(&word.letters[start], dot, good, !good);
+               }
+            }
+         }
+      }
+
+      static void *run_thread(void *job) {
+         static_cast<PatternGeneratorJob *>(job)->run();
+         return NULL;
+      }
+};
+
+/* Split the word list into one slice per thread and run the jobs. The
+ * jobs' results are left in the vector for the caller to merge. */
+static void run_jobs(vector<PatternGeneratorJob> &jobs) {
+   vector<pthread_t> thread_ids(jobs.size());
+   vector<bool> started(jobs.size(), false);
+
+   for (size_t i = 1; i < jobs.size(); i++)
+      started[i] = pthread_create(&thread_ids[i], NULL,
+         &PatternGeneratorJob::run_thread, &jobs[i]) == 0;
+
+   /* The calling thread does its share, and the share of any thread that
+    * could not be started. */
+   for (size_t i = 0; i < jobs.size(); i++)
+      if (!started[i])
+         jobs[i].run();
+   for (size_t i = 1; i < jobs.size(); i++)
+      if (started[i])
+         pthread_join(thread_ids[i], NULL);
+}
+
+static void write_utf8(ostream &o, const UniChar *characters, CFIndex length)
+{
+   CFStringRef s = CFStringCreateWithCharacters(kCFAllocatorDefault,
+      characters, length);
+   CFIndex used = 0;
+   CFStringGetBytes(s, CFRangeMake(0, length), kCFStringEncodingUTF8, 0,
+      false, NULL, 0, &used);
+   UInt8 *buffer = new UInt8[used];
+   CFStringGetBytes(s, CFRangeMake(0, length), kCFStringEncodingUTF8, 0,
+      false, buffer, used, NULL);
+   o.write((const char *)buffer, used);
+   delete[] buffer;
+   CFRelease(s);
+}
+
+static Key lowercase_characters(CFStringRef string) {
+   CFIndex length = CFStringGetLength(string);
+   CFMutableStringRef lower = CFStringCreateMutableCopy(kCFAllocatorDefault,
+      length, string);
+   CFStringLowercase(lower, NULL);
+   length = CFStringGetLength(lower);
+   Key characters(length);
+   if (length)
+      CFStringGetCharacters(lower, CFRangeMake(0, length), &characters[0]);
+   CFRelease(lower);
+   return characters;
+}
+
+/* Lowercase the key of a pattern letter by letter, since lowercasing may
+ * change the number of letters (U+0130 becomes an i and a combining dot).
+ * starts receives the index in the result of each letter of the key, and
+ * one more for its end, so that the pattern's values can be moved along.
+ * A surrogate pair is lowercased as a whole. */
+static Key lowercase_key(CFStringRef key, vector<size_t> &starts) {
+   CFIndex length = CFStringGetLength(key);
+   Key characters(length), lowered;
+   if (length)
+      CFStringGetCharacters(key, CFRangeMake(0, length), &characters[0]);
+
+   starts.clear();
+   for (CFIndex i = 0; i < length; ) {
+      CFIndex letter = 1;
+      if (characters[i] >= 0xd800 && characters[i] <= 0xdbff &&
+            i + 1 < length && characters[i + 1] >= 0xdc00 &&
+            characters[i + 1] <= 0xdfff)
+         letter = 2;
+      CFStringRef s = CFStringCreateWithSubstring(kCFAllocatorDefault, key,
+         CFRangeMake(i, letter));
+      Key lower = lowercase_characters(s);
+      CFRelease(s);
+
+      size_t start = lowered.size();
+      starts.push_back(start);
+      if (letter == 2)
+         starts.push_back(start + min((size_t)1, lower.size()));
+      lowered.insert(lowered.end(), lower.begin(), lower.end());
+      i += letter;
+   }
+   starts.push_back(lowered.size());
+   return lowered;
+}
+
+Hyphenate::PatternGenerator::PatternGenerator(int start, int end)
+: start_safe(start), end_safe(end)
+{
+   long processors = sysconf(_SC_NPROCESSORS_ONLN);
+   threads = (processors > 0) ? processors : 1;
+}
+
+Hyphenate::PatternGenerator::~PatternGenerator() {}
+
+void Hyphenate::PatternGenerator::setThreads(int t) {
+   threads = (t > 0) ? t : 1;
+}
+
+void Hyphenate::PatternGenerator::addWord(CFStringRef hyphenated_word) {
+   Key characters = lowercase_characters(hyphenated_word);
+
+   /* hyphens[i] is set if the word is hyphenated before letters[i]. */
+   Word word;
+   word.letters.push_back('.');
+   word.hyphens.push_back(false);
+   bool hyphen = false;
+   for (Key::iterator c = characters.begin(); c != characters.end(); c++) {
+      if (*c == '-') {
+         /* Hyphens at the start of the word are meaningless. */
+         hyphen = word.letters.size() > 1;
+      } else {
+         word.letters.push_back(*c);
+         word.hyphens.push_back(hyphen);
+         hyphen = false;
+      }
+   }
+   /* And so are hyphens at the end of the word. */
+   word.letters.push_back('.');
+   word.hyphens.push_back(false);
+   word.hyphens.push_back(false);
+
+   if (word.letters.size() > 2)
+      words.push_back(word);
+}
+
+void Hyphenate::PatternGenerator::loadWordList(istream &i) {
+   string word;
+   while (i >> word) {
+      CFStringRef wordString = CFStringCreateWithBytes(kCFAllocatorDefault,
+         (const UInt8 *)word.data(), word.size(), kCFStringEncodingUTF8,
+         false);
+      if (!wordString)
+         throw domain_error("libhyphenate-cfstring: Word list is not "
+            "valid UTF-8 at " + word);
+      addWord(wordString);
+      CFRelease(wordString);
+   }
+}
+
+void Hyphenate::PatternGenerator::loadPatterns(istream &i) {
+   string pattern;
+   int num_field = 0;
+   while (i >> pattern) {
+      /* The first two numerical-only words are the safe areas. */
+      if (num_field <= 1 &&
+            pattern.find_first_not_of("0123456789") == string::npos) {
+         num_field++;
+         continue;
+      }
+
+      CFStringRef patternString = CFStringCreateWithBytes(kCFAllocatorDefault,
+         (const UInt8 *)pattern.data(), pattern.size(), kCFStringEncodingUTF8,
+         false);
+      if (!patternString)
+         throw domain_error("libhyphenate-cfstring: Pattern is not "
+            "valid UTF-8 at " + pattern);
+      HyphenationRule rule(patternString);
+      CFRelease(patternString);
+      if (!rule.getKey())
+         continue;
+
+      /* The rule's values are by position in its key as written. */
+      vector<size_t> starts;
+      Key key = lowercase_key(rule.getKey(), starts);
+      vector<char> &values = patterns[key];
+      values.assign(key.size() + 1, 0);
+      for (uint o = 0; o < starts.size() && rule.hasPriority(o); o++)
+         values[starts[o]] = max(values[starts[o]], rule.priority(o));
+   }
+}
+
+Hyphenate::PatternGenerator::Statistics
+   Hyphenate::PatternGenerator::generateLevel(int level, int pattern_start,
+      int pattern_finish, int good_weight, int bad_weight, int threshold)
+{
+   if (level < 1 || level > 9)
+      throw domain_error("libhyphenate-cfstring: Hyphenation levels must "
+         "be between 1 and 9.");
+
+   size_t slice = (words.size() + threads - 1) / threads;
+   for (int length = pattern_start; length <= pattern_finish; length++) {
+      /* Count the candidates of this length in parallel... */
+      PatternIndex index(patterns);
+      vector<PatternGeneratorJob> jobs(threads);
+      for (int t = 0; t < threads; t++) {
+         jobs[t].generator = this;
+         jobs[t].index = &index;
+         jobs[t].begin = min(words.size(), t * slice);
+         jobs[t].end = min(words.size(), (t + 1) * slice);
+         jobs[t].level = level;
+         jobs[t].length = length;
+         jobs[t].candidates.setLength(length);
+      }
+      run_jobs(jobs);
+
+      /* ... merge the counts ... */
+      CandidateTable &candidates = jobs[0].candidates;
+      for (int t = 1; t < threads; t++) {
+         candidates.merge(jobs[t].candidates);
+         jobs[t].candidates = CandidateTable();
+      }
+
+      /* ... and accept the candidates that do more good than harm. The
+       * patterns must not change before counting is done since the
+       * threads read them through the index. */
+      const vector<CandidateTable::Entry> &all = candidates.all();
+      for (size_t e = 0; e < all.size(); e++) {
+         for (int dot = 0; dot <= length; dot++) {
+            long good = candidates.good(all[e], dot);
+            long bad = candidates.bad(all[e], dot);
+            if (good == 0 || good * good_weight - bad * bad_weight < threshold)
+               continue;
+            vector<char> &values =
+               patterns[Key(all[e].letters, all[e].letters + length)];
+            if (values.empty())
+               values.assign(length + 1, 0);
+            if (values[dot] < level)
+               values[dot] = level;
+         }
+      }
+   }
+
+   return evaluate();
+}
+
+Hyphenate::PatternGenerator::Statistics
+   Hyphenate::PatternGenerator::evaluate() const
+{
+   PatternIndex index(patterns);
+   size_t slice = (words.size() + threads - 1) / threads;
+   vector<PatternGeneratorJob> jobs(threads);
+   for (int t = 0; t < threads; t++) {
+      jobs[t].generator = this;
+      jobs[t].index = &index;
+      jobs[t].begin = min(words.size(), t * slice);
+      jobs[t].end = min(words.size(), (t + 1) * slice);
+      jobs[t].level = 0;
+      jobs[t].length = 0;
+   }
+   run_jobs(jobs);
+
+   Statistics total;
+   for (int t = 0; t < threads; t++) {
+      total.good += jobs[t].statistics.good;
+      total.bad += jobs[t].statistics.bad;
+      total.missed += jobs[t].statistics.missed;
+   }
+   return total;
+}
+
+void Hyphenate::PatternGenerator::writePatterns(ostream &o) const {
+   o << start_safe << " " << end_safe << "\n";
+
+   Key line;
+   for (PatternMap::const_iterator p = patterns.begin();
+         p != patterns.end(); p++) {
+      line.clear();
+      for (size_t i = 0; i <= p->first.size(); i++) {
+         if (p->second[i])
+            line.push_back('0' + p->second[i]);
+         if (i < p->first.size())
+            line.push_back(p->first[i]);
+      }
+      write_utf8(o, &line[0], line.size());
+      o << "\n";
+   }
+}
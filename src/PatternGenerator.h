@@ -0,0 +1,130 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+#ifndef HYPHENATE_PATTERN_GENERATOR_H
+#define HYPHENATE_PATTERN_GENERATOR_H
+
+#include <iostream>
+#include <map>
+#include <vector>
+#include <CoreFoundation/CoreFoundation.h>
+
+namespace Hyphenate {
+   class PatternGeneratorJob;
+
+   /** The PatternGenerator derives hyphenation patterns from a list of
+    *  correctly hyphenated words, much like Liang's patgen. Patterns are
+    *  generated level by level: odd levels introduce hyphens, even levels
+    *  inhibit the ones that were wrongly introduced before. The result is
+    *  written in the format read by HyphenationTree::loadPatterns.
+    *
+    *  The expensive part, counting how often each pattern candidate would
+    *  help or hurt, is split across several threads. */
+   class PatternGenerator {
+      public:
+         /** The outcome of applying the current patterns to the word list.
+          *  Only positions outside the safe areas at the start and end of
+          *  each word are counted. */
+         struct Statistics {
+            /** Hyphens in the word list that the patterns find. */
+            unsigned long good;
+            /** Hyphens the patterns find that are not in the word list. */
+            unsigned long bad;
+            /** Hyphens in the word list that the patterns miss. */
+            unsigned long missed;
+
+            Statistics() : good(0), bad(0), missed(0) {}
+
+            /** Percentage of hyphens in the word list that are found. */
+            double coverage() const
+               { return good + missed ? 100.0 * good / (good + missed) : 0; }
+            /** Percentage of found hyphens that are wrong. */
+            double error_rate() const
+               { return good + bad ? 100.0 * bad / (good + bad) : 0; }
+         };
+
+         /** Construct a generator for words that are not hyphenated within
+          *  start_safe characters of their start and end_safe characters
+          *  of their end. */
+         PatternGenerator(int start_safe = 2, int end_safe = 2);
+         ~PatternGenerator();
+
+         /** Read whitespace-separated, UTF-8 encoded words from the
+          *  istream. Hyphens in the words are marked by '-'. */
+         void loadWordList(std::istream &source);
+
+         /** Add a single word, with its hyphens marked by '-'. */
+         void addWord(CFStringRef hyphenated_word);
+
+         /** Read existing patterns, in the format understood by
+          *  HyphenationTree::loadPatterns, to continue training from. The
+          *  safe areas given in the file are ignored and non-standard
+          *  parts of the patterns are dropped. */
+         void loadPatterns(std::istream &source);
+
+         /** Set the number of threads used for counting. The default is
+          *  the number of online processors. */
+         void setThreads(int threads);
+
+         /** Generate the patterns for a single level. Patterns with
+          *  pattern_start up to pattern_finish letters (including the
+          *  word-boundary dots) are considered; a candidate is accepted if
+          *  good_weight * good - bad_weight * bad is at least threshold.
+          *  Levels must be generated in ascending order.
+          *
+          *  \returns The statistics after the level has been generated. */
+         Statistics generateLevel(int level, int pattern_start,
+            int pattern_finish, int good_weight, int bad_weight,
+            int threshold);
+
+         /** Apply the current patterns to the word list. */
+         Statistics evaluate() const;
+
+         /** Returns the number of patterns generated or loaded so far. */
+         size_t patternCount() const { return patterns.size(); }
+
+         /** Write the patterns, preceded by the safe areas. */
+         void writePatterns(std::ostream &target) const;
+
+      private:
+         typedef std::vector<UniChar> Key;
+         typedef std::map<Key, std::vector<char> > PatternMap;
+
+         /* A word of the list, with the dots for word start and end, and
+          * a flag for each position whether it is hyphenated before. */
+         struct Word {
+            Key letters;
+            std::vector<bool> hyphens;
+         };
+
+         int start_safe, end_safe, threads;
+         std::vector<Word> words;
+         PatternMap patterns;
+
+         PatternGenerator(const PatternGenerator &);
+         PatternGenerator &operator=(const PatternGenerator &);
+
+         friend class PatternGeneratorJob;
+   };
+}
+
+#endif
@@ -0,0 +1,155 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+/* ------------- Implementation for Preloader.h ---------------- */
+
+#include "Preloader.h"
+#include "Hyphenator.h"
+#include "PatternCatalog.h"
+#include "ThreadPool.h"
+#include <stdexcept>
+
+using namespace std;
+using namespace RFC_3066;
+using namespace Hyphenate;
+
+/* Loads the patterns for a single Handle on a pool thread. */
+class Hyphenate::PreloadJob : public ThreadPool::Job {
+   private:
+      Preloader::Handle *handle;
+   public:
+      PreloadJob(Preloader::Handle *h) : handle(h) {}
+      void run() { handle->load(); }
+};
+
+Hyphenate::Preloader::Handle::Handle(const string &t, const Language &l,
+   const PatternCatalog &c)
+: file_tag(t), lang(l), catalog(c), done(false)
+{
+   pthread_mutex_init(&lock, NULL);
+   pthread_cond_init(&finished, NULL);
+}
+
+Hyphenate::Preloader::Handle::~Handle() {
+   pthread_cond_destroy(&finished);
+   pthread_mutex_destroy(&lock);
+}
+
+void Hyphenate::Preloader::Handle::load() {
+   auto_ptr<Hyphenator> h;
+   string message;
+   try {
+      h.reset(new Hyphenator(lang, catalog));
+   } catch (const exception &e) {
+      message = e.what();
+   } catch (...) {
+      message = "libhyphenate-cfstring: Loading " + file_tag + " failed";
+   }
+
+   pthread_mutex_lock(&lock);
+   hyphenator = h;
+   error = message;
+   done = true;
+   pthread_cond_broadcast(&finished);
+   pthread_mutex_unlock(&lock);
+}
+
+bool Hyphenate::Preloader::Handle::isReady() const {
+   pthread_mutex_lock(&lock);
+   bool ready = done;
+   pthread_mutex_unlock(&lock);
+   return ready;
+}
+
+Hyphenator *Hyphenate::Preloader::Handle::get() {
+   pthread_mutex_lock(&lock);
+   Hyphenator *h = hyphenator.get();
+   pthread_mutex_unlock(&lock);
+   return h;
+}
+
+Hyphenator &Hyphenate::Preloader::Handle::wait() {
+   pthread_mutex_lock(&lock);
+   while (!done)
+      pthread_cond_wait(&finished, &lock);
+   Hyphenator *h = hyphenator.get();
+   pthread_mutex_unlock(&lock);
+
+   if (!h)
+      throw domain_error(error);
+   return *h;
+}
+
+Hyphenate::Preloader::Preloader(const PatternCatalog &c, int threads)
+: catalog(c), pool(new ThreadPool(threads))
+{
+   pthread_mutex_init(&lock, NULL);
+}
+
+Hyphenate::Preloader::Preloader(int threads)
+: catalog(PatternCatalog::standard()), pool(new ThreadPool(threads))
+{
+   pthread_mutex_init(&lock, NULL);
+}
+
+Hyphenate::Preloader::~Preloader() {
+   /* Stopping the pool finishes all queued loads, so no job can refer to
+    * a Handle afterwards. */
+   pool.reset();
+
+   for (map<string, Handle*>::iterator i = handles.begin();
+         i != handles.end(); i++)
+      delete i->second;
+   pthread_mutex_destroy(&lock);
+}
+
+Preloader::Handle &Hyphenate::Preloader::load(const Language &lang) {
+   const PatternCatalog::Entry &entry = catalog.resolve(lang);
+
+   pthread_mutex_lock(&lock);
+   map<string, Handle*>::iterator i = handles.find(entry.tag);
+   if (i != handles.end()) {
+      pthread_mutex_unlock(&lock);
+      return *i->second;
+   }
+   Handle *handle = new Handle(entry.tag, lang, catalog);
+   handles.insert(make_pair(entry.tag, handle));
+   pthread_mutex_unlock(&lock);
+
+   pool->submit(new PreloadJob(handle));
+   return *handle;
+}
+
+void Hyphenate::Preloader::waitAll() {
+   pthread_mutex_lock(&lock);
+   map<string, Handle*> current(handles);
+   pthread_mutex_unlock(&lock);
+
+   for (map<string, Handle*>::iterator i = current.begin();
+         i != current.end(); i++) {
+      try {
+         i->second->wait();
+      } catch (const domain_error &) {
+         /* The failure is reported by the Handle itself. */
+      }
+   }
+}
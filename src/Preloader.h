@@ -0,0 +1,125 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+#ifndef HYPHENATE_PRELOADER_H
+#define HYPHENATE_PRELOADER_H
+
+#include "Language.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <pthread.h>
+
+namespace Hyphenate {
+   class Hyphenator;
+   class PatternCatalog;
+   class PreloadJob;
+   class ThreadPool;
+
+   /** The Preloader builds Hyphenators for several languages at once, each
+    *  on a thread of its own pool. load() returns immediately with a
+    *  Handle; a language can be used as soon as its Handle is ready, while
+    *  other languages are still loading. The patterns are shared through
+    *  DictionaryRegistry::standard(), so pattern files with the same
+    *  contents are loaded only once.
+    *
+    *  Example:
+    *  Preloader preloader;
+    *  Preloader::Handle &en = preloader.load(Language("en"));
+    *  preloader.load(Language("de"));
+    *  en.wait().applyHyphenationRules(word);
+    */
+   class Preloader {
+      public:
+         /** The loading state of a single pattern file. */
+         class Handle {
+            public:
+               /** The tag of the pattern file, as listed in the catalog. */
+               const std::string &tag() const { return file_tag; }
+
+               /** Returns true once loading has finished, successfully
+                *  or not. */
+               bool isReady() const;
+
+               /** Returns the Hyphenator if it has been loaded, NULL
+                *  otherwise. Never blocks. */
+               Hyphenator *get();
+
+               /** Block until loading has finished and return the
+                *  Hyphenator. Throws a domain_error if loading failed. */
+               Hyphenator &wait();
+
+            private:
+               std::string file_tag;
+               RFC_3066::Language lang;
+               const PatternCatalog &catalog;
+               mutable pthread_mutex_t lock;
+               pthread_cond_t finished;
+               bool done;
+               std::auto_ptr<Hyphenator> hyphenator;
+               std::string error;
+
+               Handle(const std::string &tag, const RFC_3066::Language &lang,
+                  const PatternCatalog &catalog);
+               ~Handle();
+               void load();
+
+               Handle(const Handle &);
+               Handle &operator=(const Handle &);
+
+               friend class Preloader;
+               friend class PreloadJob;
+         };
+
+         /** Construct a Preloader resolving languages through the given
+          *  catalog and loading on the given number of threads, or one
+          *  per online processor if threads is 0. */
+         Preloader(const PatternCatalog &catalog, int threads = 0);
+
+         /** Construct a Preloader for the standard catalog. */
+         Preloader(int threads = 0);
+
+         /** Waits for all loads to finish. All Handles and Hyphenators
+          *  obtained from this Preloader are destroyed. */
+         ~Preloader();
+
+         /** Start loading the patterns for the given language, unless
+          *  they are already loading. Languages resolving to the same
+          *  pattern file share a Handle. Throws a domain_error if there
+          *  is no pattern file for the language. */
+         Handle &load(const RFC_3066::Language &lang);
+
+         /** Block until all loads started so far have finished. */
+         void waitAll();
+
+      private:
+         const PatternCatalog &catalog;
+         pthread_mutex_t lock;
+         std::map<std::string, Handle*> handles;
+         std::auto_ptr<ThreadPool> pool;
+
+         Preloader(const Preloader &);
+         Preloader &operator=(const Preloader &);
+   };
+}
+
+#endif
@@ -0,0 +1,217 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+/* ------------- Implementation for ResultCache.h ---------------- */
+
+#include "ResultCache.h"
+#include "Checksum.h"
+#include <stdexcept>
+#include <string>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+using namespace Hyphenate;
+
+/* The number of slots a word may be kept in, starting at its hash. */
+#define PROBES 8
+
+#define CACHE_MAGIC "HYPHCACH"
+#define CACHE_VERSION 1
+
+/* The file starts with a header page, followed by the slots. */
+struct CacheHeader {
+   char magic[8];
+   UInt32 version, slot_size;
+   UInt64 slot_count;
+};
+
+#define HEADER_SIZE 4096
+
+/* The length of a slot that was freed after its writer died. No word has
+ * it, so the slot matches nothing until it is written again. */
+#define UNUSABLE_LENGTH 0xffff
+
+/* A slot is written only between two increments of sequence, and is
+ * unused while sequence is 0. */
+struct Hyphenate::CacheSlot {
+   volatile UInt32 sequence;
+   volatile UInt16 length;
+   UInt16 reserved;
+   volatile UInt64 dictionary;
+   volatile UInt64 breaks;
+   volatile UniChar word[ResultCache::max_word];
+};
+
+Hyphenate::ResultCache::ResultCache(const char *path, size_t requested_slots)
+: fd(-1), mapping(MAP_FAILED), mapping_size(0), slots(NULL), slot_count(0)
+{
+   fd = open(path, O_RDWR | O_CREAT, 0666);
+   if (fd == -1)
+      throw domain_error(string("libhyphenate-cfstring: Cannot open result "
+         "cache ") + path + ": " + strerror(errno));
+
+   /* Every process using the file holds a shared lock on it. One that
+    * gets an exclusive lock is alone: it sets the file up if it is new and
+    * frees the slots of writers that died in the middle of a write. The
+    * others wait for it by asking for their shared lock. */
+   bool alone = flock(fd, LOCK_EX | LOCK_NB) == 0;
+   if (!alone)
+      flock(fd, LOCK_SH);
+   struct stat buf;
+   CacheHeader header;
+   const UInt64 max_slots = ((size_t)-1 - HEADER_SIZE) / sizeof(CacheSlot);
+   bool valid = fstat(fd, &buf) == 0;
+   if (valid && buf.st_size == 0 && alone) {
+      memset(&header, 0, sizeof(header));
+      memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+      header.version = CACHE_VERSION;
+      header.slot_size = sizeof(CacheSlot);
+      header.slot_count = requested_slots ? requested_slots : 1;
+      valid = header.slot_count <= max_slots && ftruncate(fd,
+            HEADER_SIZE + header.slot_count * sizeof(CacheSlot)) == 0
+         && pwrite(fd, &header, sizeof(header), 0) == sizeof(header)
+         && fstat(fd, &buf) == 0;
+   } else if (valid)
+      valid = pread(fd, &header, sizeof(header), 0) == sizeof(header);
+
+   /* Check the slot count before multiplying, so that a damaged header
+    * cannot wrap the size around and map too little. */
+   valid = valid && memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) == 0
+      && header.version == CACHE_VERSION && header.slot_size == sizeof(CacheSlot)
+      && header.slot_count > 0 && header.slot_count <= max_slots
+      && (UInt64)buf.st_size >= HEADER_SIZE + header.slot_count * sizeof(CacheSlot);
+   if (valid) {
+      mapping_size = HEADER_SIZE + header.slot_count * sizeof(CacheSlot);
+      mapping = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+         fd, 0);
+   }
+   if (mapping == MAP_FAILED) {
+      close(fd);
+      throw domain_error(string("libhyphenate-cfstring: ") + path +
+         " is not a usable result cache");
+   }
+   slots = (CacheSlot *)((char *)mapping + HEADER_SIZE);
+   slot_count = header.slot_count;
+
+   if (alone) {
+      /* No one else is writing, so an odd sequence belongs to a writer
+       * that is gone. Its contents may be torn; make it match nothing. */
+      for (size_t i = 0; i < slot_count; i++) {
+         if (slots[i].sequence % 2 == 0)
+            continue;
+         slots[i].length = UNUSABLE_LENGTH;
+         slots[i].sequence = (slots[i].sequence + 1 == 0)
+            ? 2 : slots[i].sequence + 1;
+      }
+      flock(fd, LOCK_SH);
+   }
+}
+
+Hyphenate::ResultCache::~ResultCache() {
+   munmap(mapping, mapping_size);
+   close(fd);
+}
+
+static size_t home_slot(UInt64 dictionary, const UniChar *word,
+   CFIndex length, size_t slot_count)
+{
+   return checksum(word, length * sizeof(UniChar), dictionary) % slot_count;
+}
+
+bool Hyphenate::ResultCache::find(UInt64 dictionary, const UniChar *word,
+   CFIndex length, UInt64 &breaks) const
+{
+   if (length > max_word)
+      return false;
+
+   size_t home = home_slot(dictionary, word, length, slot_count);
+   for (size_t p = 0; p < PROBES && p < slot_count; p++) {
+      const CacheSlot &slot = slots[(home + p) % slot_count];
+      UInt32 sequence = slot.sequence;
+      if (sequence == 0)
+         return false;
+      if (sequence % 2 == 1)
+         continue;
+      __sync_synchronize();
+
+      bool match = slot.dictionary == dictionary && slot.length == length;
+      for (CFIndex i = 0; match && i < length; i++)
+         match = slot.word[i] == word[i];
+      UInt64 found = slot.breaks;
+
+      /* Only trust what was read if no writer came in between. */
+      __sync_synchronize();
+      if (match && slot.sequence == sequence) {
+         breaks = found;
+         return true;
+      }
+   }
+   return false;
+}
+
+void Hyphenate::ResultCache::insert(UInt64 dictionary, const UniChar *word,
+   CFIndex length, UInt64 breaks)
+{
+   if (length > max_word)
+      return;
+
+   /* Take the slot already holding the word, or else the first unused
+    * one, or else evict the home slot. */
+   size_t home = home_slot(dictionary, word, length, slot_count);
+   CacheSlot *target = &slots[home];
+   for (size_t p = 0; p < PROBES && p < slot_count; p++) {
+      CacheSlot *slot = &slots[(home + p) % slot_count];
+      if (slot->sequence == 0) {
+         target = slot;
+         break;
+      }
+      bool match = slot->dictionary == dictionary && slot->length == length;
+      for (CFIndex i = 0; match && i < length; i++)
+         match = slot->word[i] == word[i];
+      if (match) {
+         target = slot;
+         break;
+      }
+   }
+
+   UInt32 sequence = target->sequence;
+   if (sequence % 2 == 1 ||
+         !__sync_bool_compare_and_swap(&target->sequence, sequence, sequence + 1))
+      return;
+   __sync_synchronize();
+
+   target->dictionary = dictionary;
+   target->length = length;
+   for (CFIndex i = 0; i < length; i++)
+      target->word[i] = word[i];
+   target->breaks = breaks;
+
+   __sync_synchronize();
+   /* Skip 0 when the counter wraps, which marks unused slots. */
+   target->sequence = (sequence + 2 == 0) ? 2 : sequence + 2;
+}
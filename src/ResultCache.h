@@ -0,0 +1,92 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+#ifndef HYPHENATE_RESULT_CACHE_H
+#define HYPHENATE_RESULT_CACHE_H
+
+#include <stddef.h>
+#include <CoreFoundation/CoreFoundation.h>
+
+namespace Hyphenate {
+   struct CacheSlot;
+
+   /** A ResultCache remembers hyphenation results in a memory-mapped file,
+    *  so that all processes using the same file share them, and a
+    *  restarted process finds the results of its previous runs. It is an
+    *  open-addressing hash table keyed by the checksum of the dictionary
+    *  (HyphenationTree::patternChecksum) and the lowercased word. Each
+    *  entry stores the break positions of a word of up to max_word
+    *  letters as a bit mask, so only words that are hyphenated by
+    *  standard rules alone are cached.
+    *
+    *  Readers and writers do not lock: every slot carries a sequence
+    *  number that is odd while the slot is written, and readers retry
+    *  elsewhere or miss if it changes under them. When all slots a word
+    *  may go to are taken, the first one is overwritten. A process dying
+    *  in the middle of a write leaves its slot locked. Every process holds
+    *  a shared flock on the file while it has it open, and the first
+    *  process to open the file while no other has it open unlocks such
+    *  slots.
+    *
+    *  See Hyphenator::setResultCache. */
+   class ResultCache {
+      private:
+         int fd;
+         void *mapping;
+         size_t mapping_size;
+         CacheSlot *slots;
+         size_t slot_count;
+
+         ResultCache(const ResultCache &);
+         ResultCache &operator=(const ResultCache &);
+
+      public:
+         /** The longest word that can be cached. */
+         static const CFIndex max_word = 52;
+
+         /** Open the cache file at path, creating it with room for the
+          *  given number of words if it does not exist. An existing file
+          *  keeps its size. Throws a domain_error if the file cannot be
+          *  opened or is not a cache file. */
+         ResultCache(const char *path, size_t slots = 65536);
+
+         ~ResultCache();
+
+         /** Look up the breaks of the lowercased word for the dictionary
+          *  with the given checksum. Bit i of breaks is set if the word
+          *  may be hyphenated before letter i. Returns false if the word
+          *  is not in the cache. */
+         bool find(UInt64 dictionary, const UniChar *word, CFIndex length,
+            UInt64 &breaks) const;
+
+         /** Remember the breaks of the lowercased word. Words longer than
+          *  max_word are ignored, as are writes racing with another writer
+          *  of the same slot. */
+         void insert(UInt64 dictionary, const UniChar *word, CFIndex length,
+            UInt64 breaks);
+
+         /** The number of words the cache can hold. */
+         size_t size() const { return slot_count; }
+   };
+}
+
+#endif
@@ -0,0 +1,95 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+/* ------------- Implementation for ThreadPool.h ---------------- */
+
+#include "ThreadPool.h"
+#include <unistd.h>
+
+using namespace std;
+using namespace Hyphenate;
+
+Hyphenate::ThreadPool::ThreadPool(int count) : stopping(false) {
+   pthread_mutex_init(&lock, NULL);
+   pthread_cond_init(&queued, NULL);
+
+   if (count <= 0) {
+      long processors = sysconf(_SC_NPROCESSORS_ONLN);
+      count = (processors > 0) ? processors : 1;
+   }
+
+   for (int i = 0; i < count; i++) {
+      pthread_t thread;
+      if (pthread_create(&thread, NULL, &ThreadPool::work, this) == 0)
+         threads.push_back(thread);
+   }
+}
+
+Hyphenate::ThreadPool::~ThreadPool() {
+   pthread_mutex_lock(&lock);
+   stopping = true;
+   pthread_cond_broadcast(&queued);
+   pthread_mutex_unlock(&lock);
+
+   for (vector<pthread_t>::iterator i = threads.begin(); i != threads.end();
+         i++)
+      pthread_join(*i, NULL);
+
+   pthread_cond_destroy(&queued);
+   pthread_mutex_destroy(&lock);
+}
+
+void Hyphenate::ThreadPool::submit(Job *job) {
+   if (threads.empty()) {
+      job->run();
+      delete job;
+      return;
+   }
+
+   pthread_mutex_lock(&lock);
+   jobs.push_back(job);
+   pthread_cond_signal(&queued);
+   pthread_mutex_unlock(&lock);
+}
+
+void *Hyphenate::ThreadPool::work(void *p) {
+   ThreadPool *pool = static_cast<ThreadPool *>(p);
+
+   pthread_mutex_lock(&pool->lock);
+   while (true) {
+      while (pool->jobs.empty() && !pool->stopping)
+         pthread_cond_wait(&pool->queued, &pool->lock);
+      /* Only stop once the queue is drained. */
+      if (pool->jobs.empty())
+         break;
+
+      Job *job = pool->jobs.front();
+      pool->jobs.pop_front();
+      pthread_mutex_unlock(&pool->lock);
+      job->run();
+      delete job;
+      pthread_mutex_lock(&pool->lock);
+   }
+   pthread_mutex_unlock(&pool->lock);
+
+   return NULL;
+}
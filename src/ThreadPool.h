@@ -0,0 +1,66 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+#ifndef HYPHENATE_THREAD_POOL_H
+#define HYPHENATE_THREAD_POOL_H
+
+#include <deque>
+#include <vector>
+#include <pthread.h>
+
+namespace Hyphenate {
+   /** A fixed set of threads working off a queue of jobs. */
+   class ThreadPool {
+      public:
+         /** A unit of work. The pool deletes each job after running it. */
+         class Job {
+            public:
+               virtual ~Job() {}
+               virtual void run() = 0;
+         };
+
+         /** Start the given number of threads, or one per online processor
+          *  if threads is 0. */
+         ThreadPool(int threads = 0);
+
+         /** Runs all jobs still queued, then stops the threads. */
+         ~ThreadPool();
+
+         /** Queue a job; the pool takes ownership of it. If no thread could
+          *  be started, the job is run right away. */
+         void submit(Job *job);
+
+      private:
+         pthread_mutex_t lock;
+         pthread_cond_t queued;
+         std::deque<Job*> jobs;
+         std::vector<pthread_t> threads;
+         bool stopping;
+
+         static void *work(void *pool);
+
+         ThreadPool(const ThreadPool &);
+         ThreadPool &operator=(const ThreadPool &);
+   };
+}
+
+#endif
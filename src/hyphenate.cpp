@@ -0,0 +1,379 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+/* ------------- Implementation for hyphenate.h ---------------- */
+
+#include "hyphenate.h"
+#include "HyphenationTree.h"
+#include "DictionaryRegistry.h"
+#include "NumaNodes.h"
+#include "OverlayDictionary.h"
+#include "PatternCatalog.h"
+#include "Language.h"
+#include <memory>
+#include <vector>
+
+using namespace std;
+using namespace Hyphenate;
+
+/* Words up to this length are handled without allocating, unless they have
+ * uppercase letters outside of ASCII. */
+#define SHORT_WORD 64
+
+/* A file opened by path has a tree of its own. A language's tree and, for a
+ * dialect, its overlay are borrowed from DictionaryRegistry::standard(),
+ * with a copy for each NUMA node if the registry keeps them. */
+struct hyphenate_dictionary {
+   auto_ptr<HyphenationTree> owned_tree;
+   vector<const HyphenationTree*> trees;
+   vector<const OverlayDictionary*> overlays;
+   const NumaNodes *nodes;
+
+   hyphenate_dictionary() : nodes(NULL) {}
+};
+
+/* The copy of the dictionary to use for the calling thread. */
+static size_t local_node(const hyphenate_dictionary *dictionary) {
+   return dictionary->nodes ? dictionary->nodes->current() : 0;
+}
+
+static void apply_patterns(const hyphenate_dictionary *dictionary,
+   size_t node, const UniChar *characters, size_t length,
+   const HyphenationRule **rules)
+{
+   if (dictionary->overlays[node])
+      dictionary->overlays[node]->applyPatterns(characters, length, rules);
+   else
+      dictionary->trees[node]->applyPatterns(characters, length, rules);
+}
+
+static uint16_t rule_id(const hyphenate_dictionary *dictionary, size_t node,
+   const HyphenationRule *rule)
+{
+   int id = dictionary->overlays[node]
+      ? dictionary->overlays[node]->ruleId(rule)
+      : dictionary->trees[node]->ruleId(rule);
+   return (id < 0 || id >= HYPHENATE_NO_RULE) ? HYPHENATE_NO_RULE : id;
+}
+
+/* Write the breaks given by the rules for each character of a word to the
+ * caller's arrays. offsets maps each character to the position reported for
+ * it, or is NULL if the position is the character index. */
+static int report_breaks(const hyphenate_dictionary *dictionary,
+   size_t node, const HyphenationRule *const *rules, size_t length,
+   const uint32_t *offsets, uint32_t *positions, uint16_t *rule_ids,
+   size_t capacity, size_t *count)
+{
+   size_t found = 0;
+   for (size_t i = 0; i < length; i++) {
+      if (!rules[i])
+         continue;
+      if (found < capacity) {
+         positions[found] = offsets ? offsets[i] : i;
+         if (rule_ids)
+            rule_ids[found] = rule_id(dictionary, node, rules[i]);
+      }
+      found++;
+   }
+
+   *count = found;
+   return (found > capacity) ? HYPHENATE_BUFFER_TOO_SMALL : HYPHENATE_OK;
+}
+
+/* Hyphenate UTF-16 characters and report the breaks as above. */
+static int hyphenate_characters(const hyphenate_dictionary *dictionary,
+   const UniChar *characters, size_t length, const uint32_t *offsets,
+   uint32_t *positions, uint16_t *rule_ids, size_t capacity, size_t *count)
+{
+   const HyphenationRule *short_rules[SHORT_WORD];
+   vector<const HyphenationRule*> long_rules;
+   const HyphenationRule **rules = short_rules;
+   if (length > SHORT_WORD) {
+      long_rules.resize(length);
+      rules = &long_rules[0];
+   }
+
+   size_t node = local_node(dictionary);
+   apply_patterns(dictionary, node, characters, length, rules);
+   return report_breaks(dictionary, node, rules, length, offsets,
+      positions, rule_ids, capacity, count);
+}
+
+/* The smallest code point that needs a sequence with the given number of
+ * continuation bytes; anything below it is an overlong form. */
+static const uint32_t shortest_form[4] = { 0, 0x80, 0x800, 0x10000 };
+
+/* Decode UTF-8 into UTF-16, remembering the byte offset of each UTF-16
+ * code unit. Returns false if the text is not valid UTF-8: overlong
+ * forms, surrogates and code points above U+10FFFF are rejected. */
+static bool decode_utf8(const char *text, size_t length,
+   UniChar *characters, uint32_t *offsets, size_t *decoded)
+{
+   const unsigned char *bytes = (const unsigned char *)text;
+   size_t n = 0;
+   for (size_t i = 0; i < length; ) {
+      uint32_t c = bytes[i];
+      int continuation;
+      if (c < 0x80) { continuation = 0; }
+      else if ((c & 0xe0) == 0xc0) { continuation = 1; c &= 0x1f; }
+      else if ((c & 0xf0) == 0xe0) { continuation = 2; c &= 0x0f; }
+      else if ((c & 0xf8) == 0xf0) { continuation = 3; c &= 0x07; }
+      else return false;
+
+      if (i + continuation >= length)
+         return false;
+      for (int k = 1; k <= continuation; k++) {
+         if ((bytes[i + k] & 0xc0) != 0x80)
+            return false;
+         c = (c << 6) | (bytes[i + k] & 0x3f);
+      }
+      if (c < shortest_form[continuation] || c > 0x10ffff ||
+            (c >= 0xd800 && c <= 0xdfff))
+         return false;
+
+      if (c >= 0x10000) {
+         c -= 0x10000;
+         offsets[n] = i;
+         characters[n++] = 0xd800 | (c >> 10);
+         offsets[n] = i;
+         characters[n++] = 0xdc00 | (c & 0x3ff);
+      } else {
+         offsets[n] = i;
+         characters[n++] = c;
+      }
+      i += 1 + continuation;
+   }
+   *decoded = n;
+   return true;
+}
+
+extern "C" hyphenate_dictionary *hyphenate_open_file(const char *path) {
+   if (!path)
+      return NULL;
+   try {
+      auto_ptr<hyphenate_dictionary> dictionary(new hyphenate_dictionary);
+      dictionary->owned_tree.reset(new HyphenationTree());
+      dictionary->owned_tree->loadPatterns(path);
+      dictionary->trees.push_back(dictionary->owned_tree.get());
+      dictionary->overlays.push_back(NULL);
+      return dictionary.release();
+   } catch (...) {
+      return NULL;
+   }
+}
+
+extern "C" hyphenate_dictionary *hyphenate_open_language(const char *tag) {
+   if (!tag)
+      return NULL;
+   try {
+      RFC_3066::Language lang(tag);
+      const PatternCatalog &catalog = PatternCatalog::standard();
+      const PatternCatalog::Entry &entry = catalog.resolve(lang);
+      DictionaryRegistry &registry = DictionaryRegistry::standard();
+
+      auto_ptr<hyphenate_dictionary> dictionary(new hyphenate_dictionary);
+      dictionary->nodes = registry.nodes();
+      for (size_t n = 0; n < registry.copies(); n++) {
+         if (entry.base.empty()) {
+            dictionary->trees.push_back(&registry.tree(entry, n));
+            dictionary->overlays.push_back(NULL);
+         } else {
+            dictionary->overlays.push_back(
+               &registry.dialect(catalog, entry, n));
+            dictionary->trees.push_back(&dictionary->overlays.back()->base());
+         }
+      }
+      return dictionary.release();
+   } catch (...) {
+      return NULL;
+   }
+}
+
+extern "C" void hyphenate_close(hyphenate_dictionary *dictionary) {
+   delete dictionary;
+}
+
+extern "C" int hyphenate_utf16(const hyphenate_dictionary *dictionary,
+   const uint16_t *word, size_t length,
+   uint32_t *positions, uint16_t *rule_ids, size_t capacity, size_t *count)
+{
+   if (!dictionary || !count || (!word && length) || (!positions && capacity))
+      return HYPHENATE_INVALID_ARGUMENT;
+   try {
+      return hyphenate_characters(dictionary, word, length, NULL,
+         positions, rule_ids, capacity, count);
+   } catch (...) {
+      return HYPHENATE_ERROR;
+   }
+}
+
+extern "C" int hyphenate_utf8(const hyphenate_dictionary *dictionary,
+   const char *word, size_t length,
+   uint32_t *positions, uint16_t *rule_ids, size_t capacity, size_t *count)
+{
+   if (!dictionary || !count || (!word && length) || (!positions && capacity))
+      return HYPHENATE_INVALID_ARGUMENT;
+   try {
+      /* A UTF-8 word never has more UTF-16 code units than bytes. */
+      UniChar short_characters[SHORT_WORD];
+      uint32_t short_offsets[SHORT_WORD];
+      vector<UniChar> long_characters;
+      vector<uint32_t> long_offsets;
+      UniChar *characters = short_characters;
+      uint32_t *offsets = short_offsets;
+      if (length > SHORT_WORD) {
+         long_characters.resize(length);
+         long_offsets.resize(length);
+         characters = &long_characters[0];
+         offsets = &long_offsets[0];
+      }
+
+      size_t decoded;
+      if (!decode_utf8(word, length, characters, offsets, &decoded))
+         return HYPHENATE_INVALID_ARGUMENT;
+      return hyphenate_characters(dictionary, characters, decoded, offsets,
+         positions, rule_ids, capacity, count);
+   } catch (...) {
+      return HYPHENATE_ERROR;
+   }
+}
+
+/* Make the words of a batch available as UTF-16 characters. UTF-16 words
+ * are used in place; UTF-8 words are decoded into buffer, with the byte
+ * offset of each character in offsets. Returns false if a word is not
+ * valid UTF-8. */
+static bool batch_characters(const uint16_t *const *words,
+   const size_t *lengths, size_t word_count, vector<UniChar> &,
+   vector<uint32_t> &, const UniChar **characters, CFIndex *character_counts,
+   const uint32_t **word_offsets)
+{
+   for (size_t i = 0; i < word_count; i++) {
+      characters[i] = words[i];
+      character_counts[i] = lengths[i];
+      word_offsets[i] = NULL;
+   }
+   return true;
+}
+
+static bool batch_characters(const char *const *words,
+   const size_t *lengths, size_t word_count, vector<UniChar> &buffer,
+   vector<uint32_t> &offsets, const UniChar **characters,
+   CFIndex *character_counts, const uint32_t **word_offsets)
+{
+   size_t bytes = 0;
+   for (size_t i = 0; i < word_count; i++)
+      bytes += lengths[i];
+   buffer.resize(bytes + 1);
+   offsets.resize(bytes + 1);
+
+   size_t used = 0;
+   for (size_t i = 0; i < word_count; i++) {
+      size_t decoded;
+      if (!decode_utf8(words[i], lengths[i], &buffer[used], &offsets[used],
+            &decoded))
+         return false;
+      characters[i] = &buffer[used];
+      character_counts[i] = decoded;
+      word_offsets[i] = &offsets[used];
+      used += decoded;
+   }
+   return true;
+}
+
+/* The batch calls hyphenate all words and then fill the output arrays word
+ * after word, carrying on with the counting once a word does not fit. */
+template <class Character>
+static int hyphenate_batch(const hyphenate_dictionary *dictionary,
+   const Character *const *words, const size_t *lengths, size_t word_count,
+   uint32_t *positions, uint16_t *rule_ids, size_t capacity,
+   size_t *counts, size_t *total)
+{
+   if (!dictionary || !total || (word_count && (!words || !lengths || !counts)))
+      return HYPHENATE_INVALID_ARGUMENT;
+   for (size_t i = 0; i < word_count; i++)
+      if (!words[i] && lengths[i])
+         return HYPHENATE_INVALID_ARGUMENT;
+
+   try {
+      vector<const UniChar*> characters(word_count + 1);
+      vector<CFIndex> character_counts(word_count + 1);
+      vector<const uint32_t*> word_offsets(word_count + 1);
+      vector<UniChar> buffer;
+      vector<uint32_t> offsets;
+      if (!batch_characters(words, lengths, word_count, buffer, offsets,
+            &characters[0], &character_counts[0], &word_offsets[0]))
+         return HYPHENATE_INVALID_ARGUMENT;
+
+      size_t letters = 0;
+      for (size_t i = 0; i < word_count; i++)
+         letters += character_counts[i];
+      vector<const HyphenationRule*> rules(letters + 1);
+      vector<const HyphenationRule**> outputs(word_count + 1);
+      for (size_t i = 0, used = 0; i < word_count; i++) {
+         outputs[i] = &rules[used];
+         used += character_counts[i];
+      }
+      size_t node = local_node(dictionary);
+      for (size_t i = 0; i < word_count; i++)
+         apply_patterns(dictionary, node, characters[i],
+            character_counts[i], outputs[i]);
+
+      /* Count the breaks of each word first, so that nothing is written
+       * from the first word that does not fit on. */
+      int status = HYPHENATE_OK;
+      size_t used = 0;
+      for (size_t i = 0; i < word_count; i++) {
+         report_breaks(dictionary, node, outputs[i], character_counts[i],
+            NULL, NULL, NULL, 0, &counts[i]);
+         if (status == HYPHENATE_OK && counts[i] > capacity - used)
+            status = HYPHENATE_BUFFER_TOO_SMALL;
+         if (status == HYPHENATE_OK && counts[i])
+            report_breaks(dictionary, node, outputs[i], character_counts[i],
+               word_offsets[i], positions + used,
+               rule_ids ? rule_ids + used : NULL, counts[i], &counts[i]);
+         used += counts[i];
+      }
+
+      *total = used;
+      return status;
+   } catch (...) {
+      return HYPHENATE_ERROR;
+   }
+}
+
+extern "C" int hyphenate_utf16_batch(const hyphenate_dictionary *dictionary,
+   const uint16_t *const *words, const size_t *lengths, size_t word_count,
+   uint32_t *positions, uint16_t *rule_ids, size_t capacity,
+   size_t *counts, size_t *total)
+{
+   return hyphenate_batch(dictionary, words, lengths, word_count, positions,
+      rule_ids, capacity, counts, total);
+}
+
+extern "C" int hyphenate_utf8_batch(const hyphenate_dictionary *dictionary,
+   const char *const *words, const size_t *lengths, size_t word_count,
+   uint32_t *positions, uint16_t *rule_ids, size_t capacity,
+   size_t *counts, size_t *total)
+{
+   return hyphenate_batch(dictionary, words, lengths, word_count, positions,
+      rule_ids, capacity, counts, total);
+}
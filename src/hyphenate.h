@@ -0,0 +1,116 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+/* The C interface to libhyphenate-cfstring, for use from C and through the
+ * foreign function interfaces of other languages. Text is passed as
+ * borrowed (pointer, length) buffers, which are never copied into a
+ * CFString unless they contain uppercase letters outside of ASCII, and
+ * results are written into arrays owned by the caller. No function keeps
+ * a pointer to its arguments after it returns.
+ *
+ * A break position p means that the word may be hyphenated before the
+ * character (UTF-16 code unit or UTF-8 byte) at offset p. Alongside each
+ * position, a rule id is reported: 0 for a standard hyphenation, and 1
+ * and up for the non-standard rules of the dictionary (see
+ * README.nonstandard), as numbered by HyphenationTree::ruleId, or by
+ * OverlayDictionary::ruleId for a dialect. A rule whose number does not
+ * fit is reported as HYPHENATE_NO_RULE.
+ *
+ * A dictionary may be used from several threads at once. */
+
+#ifndef HYPHENATE_C_H
+#define HYPHENATE_C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** The opaque handle to a loaded dictionary. */
+typedef struct hyphenate_dictionary hyphenate_dictionary;
+
+/** The rule id reported for a rule that has no number below it. */
+#define HYPHENATE_NO_RULE 0xffff
+
+/** Return codes of the functions below. */
+enum {
+   HYPHENATE_OK = 0,
+   /** The output arrays are too small; the required size has been
+    *  stored in the count. */
+   HYPHENATE_BUFFER_TOO_SMALL = -1,
+   /** An argument is NULL where it must not be, or text is not valid
+    *  UTF-8, which includes overlong forms and encoded surrogates. */
+   HYPHENATE_INVALID_ARGUMENT = -2,
+   /** Any other failure. */
+   HYPHENATE_ERROR = -3
+};
+
+/** Load a dictionary from a pattern file. Returns NULL on failure. */
+hyphenate_dictionary *hyphenate_open_file(const char *path);
+
+/** Load the dictionary for an RFC 3066 language tag from the standard
+ *  pattern directory, as Hyphenator does, including dialects. The patterns
+ *  are shared with all Hyphenators and dictionaries of the process that
+ *  use the same pattern file, and stay loaded when the dictionary is
+ *  closed. Returns NULL on failure. */
+hyphenate_dictionary *hyphenate_open_language(const char *tag);
+
+/** Free a dictionary. */
+void hyphenate_close(hyphenate_dictionary *dictionary);
+
+/** Hyphenate a single UTF-16 word. Up to capacity break positions and
+ *  their rule ids are written to positions and rule_ids; rule_ids may be
+ *  NULL. The number of breaks is stored in *count. */
+int hyphenate_utf16(const hyphenate_dictionary *dictionary,
+   const uint16_t *word, size_t length,
+   uint32_t *positions, uint16_t *rule_ids, size_t capacity, size_t *count);
+
+/** Like hyphenate_utf16, for a UTF-8 word. Positions are byte offsets. */
+int hyphenate_utf8(const hyphenate_dictionary *dictionary,
+   const char *word, size_t length,
+   uint32_t *positions, uint16_t *rule_ids, size_t capacity, size_t *count);
+
+/** Hyphenate word_count UTF-16 words in a single call. The breaks of all
+ *  words are written one word after the other; counts[i] receives the
+ *  number of breaks of word i, and *total the number of all breaks. If
+ *  the arrays are too small, the breaks of the words before the first
+ *  one that does not fit completely are still written, nothing of that
+ *  word and the ones after it is, counts is filled for all words and
+ *  *total is the capacity needed. */
+int hyphenate_utf16_batch(const hyphenate_dictionary *dictionary,
+   const uint16_t *const *words, const size_t *lengths, size_t word_count,
+   uint32_t *positions, uint16_t *rule_ids, size_t capacity,
+   size_t *counts, size_t *total);
+
+/** Like hyphenate_utf16_batch, for UTF-8 words. */
+int hyphenate_utf8_batch(const hyphenate_dictionary *dictionary,
+   const char *const *words, const size_t *lengths, size_t word_count,
+   uint32_t *positions, uint16_t *rule_ids, size_t capacity,
+   size_t *counts, size_t *total);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
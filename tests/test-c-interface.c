@@ -0,0 +1,170 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+/* Tests of the C interface in hyphenate.h. */
+
+#include "hyphenate.h"
+#include <stdio.h>
+#include <string.h>
+
+static int failures = 0;
+
+static void check(int condition, const char *what) {
+   if (!condition) {
+      printf("%s\n", what);
+      failures++;
+   }
+}
+
+static int same(const uint32_t *positions, size_t count,
+      const uint32_t *expected, size_t expected_count) {
+   return count == expected_count &&
+      memcmp(positions, expected, count * sizeof(uint32_t)) == 0;
+}
+
+static void test_words(const hyphenate_dictionary *d) {
+   static const uint32_t schiffahrt[] = { 5 };
+   static const uint32_t ueberweisung_utf8[] = { 5, 8, 13, 17 };
+   static const uint32_t ueberweisung_utf16[] = { 4, 7, 12, 15 };
+   static const uint16_t ueberweisung[] = { 0xdc, 'b', 'e', 'r', 'w', 'e',
+      'i', 's', 'u', 'n', 'g', 's', 't', 'r', 0xe4, 'g', 'e', 'r' };
+   uint32_t positions[16];
+   uint16_t rule_ids[16];
+   size_t count;
+
+   check(hyphenate_utf8(d, "Schiffahrt", 10, positions, rule_ids, 16,
+      &count) == HYPHENATE_OK && same(positions, count, schiffahrt, 1) &&
+      rule_ids[0] == 0, "Schiffahrt");
+   /* UTF-8 positions count bytes, UTF-16 positions code units. */
+   check(hyphenate_utf8(d, "\xc3\x9c" "berweisungstr\xc3\xa4ger", 20,
+      positions, NULL, 16, &count) == HYPHENATE_OK &&
+      same(positions, count, ueberweisung_utf8, 4), "UTF-8 offsets");
+   check(hyphenate_utf16(d, ueberweisung, 18, positions, NULL, 16,
+      &count) == HYPHENATE_OK &&
+      same(positions, count, ueberweisung_utf16, 4), "UTF-16 offsets");
+   check(hyphenate_utf8(d, "", 0, positions, NULL, 16, &count) ==
+      HYPHENATE_OK && count == 0, "empty word");
+}
+
+static void test_invalid_utf8(const hyphenate_dictionary *d) {
+   static const char *const invalid[] = {
+      "\xc0\x80",          /* overlong NUL */
+      "\xc1\xbf",          /* overlong two-byte form */
+      "\xe0\x80\xaf",      /* overlong three-byte form */
+      "\xf0\x8f\xbf\xbf",  /* overlong four-byte form */
+      "\xed\xa0\x80",      /* high surrogate */
+      "\xed\xbf\xbf",      /* low surrogate */
+      "\xf4\x90\x80\x80",  /* above U+10FFFF */
+      "\xf5\x80\x80\x80",  /* no such lead byte */
+      "\xff",
+      "\x80",              /* continuation without a lead byte */
+      "ab\xe2\x82",        /* truncated */
+      "a\xc3" "b"          /* continuation missing */
+   };
+   static const char *const valid[] = {
+      "\xc2\x80", "\xc3\xa4", "\xed\x9f\xbf", "\xee\x80\x80",
+      "\xf0\x90\x80\x80", "\xf4\x8f\xbf\xbf"
+   };
+   uint32_t positions[8];
+   size_t count, i;
+
+   for (i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+      if (hyphenate_utf8(d, invalid[i], strlen(invalid[i]), positions,
+            NULL, 8, &count) != HYPHENATE_INVALID_ARGUMENT)
+         printf("invalid UTF-8 case %lu accepted\n", (unsigned long)i),
+            failures++;
+   }
+   for (i = 0; i < sizeof(valid) / sizeof(valid[0]); i++) {
+      if (hyphenate_utf8(d, valid[i], strlen(valid[i]), positions,
+            NULL, 8, &count) != HYPHENATE_OK)
+         printf("valid UTF-8 case %lu rejected\n", (unsigned long)i),
+            failures++;
+   }
+   check(hyphenate_utf8(d, NULL, 1, positions, NULL, 8, &count) ==
+      HYPHENATE_INVALID_ARGUMENT, "NULL word");
+   check(hyphenate_utf8(NULL, "a", 1, positions, NULL, 8, &count) ==
+      HYPHENATE_INVALID_ARGUMENT, "NULL dictionary");
+}
+
+static void test_buffer_too_small(const hyphenate_dictionary *d) {
+   const char *word = "Donaudampfschiffahrtsgesellschaft";
+   uint32_t positions[8];
+   size_t count;
+
+   check(hyphenate_utf8(d, word, strlen(word), positions, NULL, 3,
+      &count) == HYPHENATE_BUFFER_TOO_SMALL && count == 7,
+      "single word too small");
+   check(hyphenate_utf8(d, word, strlen(word), NULL, NULL, 0, &count) ==
+      HYPHENATE_BUFFER_TOO_SMALL && count == 7, "single word, no buffer");
+   check(hyphenate_utf8(d, word, strlen(word), positions, NULL, 7,
+      &count) == HYPHENATE_OK && count == 7, "single word, exact fit");
+}
+
+static void test_batch(const hyphenate_dictionary *d) {
+   const char *words[] = { "Schiffahrt", "Donaudampfschiffahrtsgesellschaft",
+      "Schiffahrt" };
+   static const uint32_t all[] = { 5, 2, 5, 10, 15, 21, 23, 27, 5 };
+   size_t lengths[3], counts[3], total, capacity, i;
+   uint32_t positions[16];
+   uint16_t rule_ids[16];
+
+   for (i = 0; i < 3; i++)
+      lengths[i] = strlen(words[i]);
+
+   /* A word that does not fit completely leaves the arrays alone from
+    * where it would start, while counts and total are still filled. */
+   for (capacity = 0; capacity < 9; capacity++) {
+      size_t written = capacity == 8 ? 8 : capacity > 0 ? 1 : 0;
+      memset(positions, 0xff, sizeof(positions));
+      if (hyphenate_utf8_batch(d, words, lengths, 3, positions, rule_ids,
+            capacity, counts, &total) != HYPHENATE_BUFFER_TOO_SMALL ||
+            total != 9 || counts[0] != 1 || counts[1] != 7 ||
+            counts[2] != 1 || !same(positions, written, all, written) ||
+            positions[written] != 0xffffffff) {
+         printf("batch with capacity %lu\n", (unsigned long)capacity);
+         failures++;
+      }
+   }
+   check(hyphenate_utf8_batch(d, words, lengths, 3, positions, rule_ids, 9,
+      counts, &total) == HYPHENATE_OK && same(positions, total, all, 9),
+      "batch, exact fit");
+}
+
+int main(int argc, char **argv) {
+   char path[1024];
+   hyphenate_dictionary *d;
+
+   if (argc < 2)
+      return 2;
+   snprintf(path, sizeof(path), "%s/de", argv[1]);
+   d = hyphenate_open_file(path);
+   check(d != NULL, "cannot open the de patterns");
+   if (d) {
+      test_words(d);
+      test_invalid_utf8(d);
+      test_buffer_too_small(d);
+      test_batch(d);
+      hyphenate_close(d);
+   }
+   check(hyphenate_open_file("/nonexistent") == NULL, "open nonexistent");
+   return failures != 0;
+}
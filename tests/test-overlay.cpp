@@ -0,0 +1,126 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+/* Tests that an OverlayDictionary gives the same results as a copy of its
+ * base with the overlay's patterns inserted after the base's. */
+
+#include "HyphenationRule.h"
+#include "HyphenationTree.h"
+#include "OverlayDictionary.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace Hyphenate;
+
+/* The base has f1fa; the overlay first raises it to f4fa and then
+ * removes it. The others are new, one of them non-standard. */
+static const char *const overlay_patterns =
+   "f4fa\n" "ffa\n" "ba1hn\n" "1xy\n" "schif1fahrt/ff=,4,1\n";
+
+static int failures = 0;
+
+static void check(bool condition, const string &what) {
+   if (!condition) {
+      cout << what << endl;
+      failures++;
+   }
+}
+
+static string marked(CFStringRef word,
+      const vector<const HyphenationRule*> &rules) {
+   string result;
+   for (CFIndex i = 0; i < CFStringGetLength(word); i++) {
+      if (rules[i])
+         result += rules[i]->isNonStandard() ? "=" : "-";
+      UniChar c = CFStringGetCharacterAtIndex(word, i);
+      CFStringRef letter = CFStringCreateWithCharacters(kCFAllocatorDefault,
+         &c, 1);
+      char buffer[8];
+      if (CFStringGetCString(letter, buffer, sizeof(buffer),
+            kCFStringEncodingUTF8))
+         result += buffer;
+      CFRelease(letter);
+   }
+   return result;
+}
+
+static string hyphenate(const OverlayDictionary &overlay, const char *word) {
+   CFStringRef s = CFStringCreateWithCString(kCFAllocatorDefault, word,
+      kCFStringEncodingUTF8);
+   string result = marked(s, *overlay.applyPatterns(s));
+   CFRelease(s);
+   return result;
+}
+
+int main(int argc, char **argv) {
+   if (argc < 2)
+      return 2;
+   string base_file = string(argv[1]) + "/de";
+
+   HyphenationTree base, copy;
+   base.loadPatterns(base_file.c_str());
+   copy.loadPatterns(base_file.c_str());
+   istringstream copy_patterns(overlay_patterns);
+   copy.loadPatterns(copy_patterns);
+
+   OverlayDictionary overlay(base), other(base);
+   istringstream patterns(overlay_patterns);
+   overlay.loadPatterns(patterns);
+   istringstream other_patterns("s1c\n");
+   other.loadPatterns(other_patterns);
+
+   check(hyphenate(overlay, "Stoffabrik") == "Stoffa-brik",
+      "Stoffabrik gave " + hyphenate(overlay, "Stoffabrik"));
+   check(hyphenate(overlay, "Eisenbahn") == "Ei-sen-ba-hn",
+      "Eisenbahn gave " + hyphenate(overlay, "Eisenbahn"));
+   check(hyphenate(overlay, "Schiffahrt") == "Schif=fahrt",
+      "Schiffahrt gave " + hyphenate(overlay, "Schiffahrt"));
+   /* Another overlay on the same base sees none of it. */
+   check(hyphenate(other, "Stoffabrik") == "Stof-fa-brik",
+      "other overlay: Stoffabrik gave " + hyphenate(other, "Stoffabrik"));
+   check(overlay.patternChecksum() != base.patternChecksum() &&
+      overlay.patternChecksum() != other.patternChecksum(),
+      "overlay checksums");
+
+   ifstream words("words");
+   string word;
+   int differing = 0;
+   while (getline(words, word)) {
+      CFStringRef s = CFStringCreateWithBytes(kCFAllocatorDefault,
+         (const UInt8 *)word.data(), word.size(), kCFStringEncodingUTF8,
+         false);
+      if (!s)
+         continue;
+      string got = marked(s, *overlay.applyPatterns(s)),
+         expected = marked(s, *copy.applyPatterns(s));
+      if (got != expected && differing++ < 10)
+         cout << word << " gave " << got << ", expected " << expected
+            << endl;
+      CFRelease(s);
+   }
+   check(differing == 0, "overlay and copy differ");
+   return failures != 0;
+}
@@ -0,0 +1,111 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+/* Tests that each language hyphenates the words in the file words as
+ * recorded in expected/<language>: '-' before a standard hyphenation
+ * point and '=' before a non-standard one. The recorded results were
+ * made before pattern values were stored as shared op chains, and the
+ * whole word, UTF-16 and ranged lookups must all agree with them. */
+
+#include "Hyphenator.h"
+#include "HyphenationRule.h"
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace Hyphenate;
+
+static string utf8(const UniChar *characters, CFIndex length) {
+   CFStringRef s = CFStringCreateWithCharacters(kCFAllocatorDefault,
+      characters, length);
+   char buffer[64];
+   string result;
+   if (CFStringGetCString(s, buffer, sizeof(buffer), kCFStringEncodingUTF8))
+      result = buffer;
+   CFRelease(s);
+   return result;
+}
+
+/* Returns the number of words that did not come out as expected. */
+static int test_language(const string &patterns, const char *language) {
+   Hyphenator hyphenator((patterns + "/" + language).c_str());
+   ifstream words("words"), expected((string("expected/") + language).c_str());
+   string word, marked;
+   int failures = 0;
+
+   while (getline(words, word) && getline(expected, marked)) {
+      CFStringRef s = CFStringCreateWithBytes(kCFAllocatorDefault,
+         (const UInt8 *)word.data(), word.size(), kCFStringEncodingUTF8,
+         false);
+      if (!s)
+         continue;
+      CFIndex length = CFStringGetLength(s);
+      vector<UniChar> characters(length + 1);
+      CFStringGetCharacters(s, CFRangeMake(0, length), &characters[0]);
+
+      auto_ptr<vector<const HyphenationRule*> > rules =
+         hyphenator.applyHyphenationRules(s);
+      auto_ptr<vector<const HyphenationRule*> > ranged =
+         hyphenator.applyHyphenationRules(s, CFRangeMake(0, length));
+      vector<const HyphenationRule*> unichar_rules(length + 1);
+      hyphenator.applyHyphenationRules(&characters[0], length,
+         &unichar_rules[0]);
+
+      string result;
+      bool agree = true;
+      for (CFIndex i = 0; i < length; i++) {
+         const HyphenationRule *rule = (*rules)[i];
+         if (rule)
+            result += rule->isNonStandard() ? "=" : "-";
+         result += utf8(&characters[i], 1);
+         agree = agree && (*ranged)[i] == rule && unichar_rules[i] == rule;
+      }
+      if (result != marked || !agree) {
+         if (failures < 10)
+            cout << language << ": " << word << " gave " << result
+               << (agree ? "" : " (lookups disagree)") << ", expected "
+               << marked << endl;
+         failures++;
+      }
+      CFRelease(s);
+   }
+   if (getline(words, word) || getline(expected, marked)) {
+      cout << language << ": word and expected lists differ in length"
+         << endl;
+      failures++;
+   }
+   return failures;
+}
+
+int main(int argc, char **argv) {
+   static const char *const languages[] =
+      { "de", "de-1901", "en", "es", "fr" };
+   if (argc < 2)
+      return 2;
+
+   int failures = 0;
+   for (size_t i = 0; i < sizeof(languages) / sizeof(languages[0]); i++)
+      failures += test_language(argv[1], languages[i]);
+   return failures != 0;
+}
@@ -0,0 +1,133 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+/* Tests of the DictionaryRegistry: files with the same patterns share
+ * one tree, and a load that fails is reported to everyone waiting for it
+ * and tried again on the next request. */
+
+#include "DictionaryRegistry.h"
+#include "HyphenationTree.h"
+#include "PatternCatalog.h"
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <pthread.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace Hyphenate;
+
+static int failures = 0;
+
+static void check(bool condition, const string &what) {
+   if (!condition) {
+      cout << what << endl;
+      failures++;
+   }
+}
+
+static void copy_file(const string &from, const string &to) {
+   ifstream in(from.c_str(), ios::binary);
+   ofstream out(to.c_str(), ios::binary);
+   out << in.rdbuf();
+}
+
+/* A thread asking the registry for a tree. */
+struct Request {
+   DictionaryRegistry *registry;
+   const PatternCatalog::Entry *entry;
+   const HyphenationTree *tree;
+   bool failed;
+};
+
+static void *request_tree(void *argument) {
+   Request *request = static_cast<Request *>(argument);
+   try {
+      request->tree = &request->registry->tree(*request->entry);
+   } catch (const domain_error &) {
+      request->failed = true;
+   }
+   return NULL;
+}
+
+/* Asks for the entry's tree from several threads at once. Returns the
+ * number of requests that failed, and the tree of the others. */
+static int request_concurrently(DictionaryRegistry &registry,
+      const PatternCatalog::Entry &entry, const HyphenationTree *&tree) {
+   const int threads = 8;
+   Request requests[threads];
+   pthread_t ids[threads];
+   int failed = 0;
+
+   tree = NULL;
+   for (int t = 0; t < threads; t++) {
+      requests[t].registry = &registry;
+      requests[t].entry = &entry;
+      requests[t].tree = NULL;
+      requests[t].failed = false;
+      pthread_create(&ids[t], NULL, request_tree, &requests[t]);
+   }
+   for (int t = 0; t < threads; t++) {
+      pthread_join(ids[t], NULL);
+      if (requests[t].failed)
+         failed++;
+      else if (!tree)
+         tree = requests[t].tree;
+      else
+         check(tree == requests[t].tree, "threads got different trees");
+   }
+   return failed;
+}
+
+int main(int argc, char **argv) {
+   if (argc < 3)
+      return 2;
+   string scratch = argv[2];
+   copy_file(string(argv[1]) + "/de", scratch + "/aa");
+   copy_file(string(argv[1]) + "/de", scratch + "/bb");
+   /* A node profile that cannot be read makes loading aa fail. */
+   ofstream(string(scratch + "/aa.profile").c_str()) << "garbage\n";
+
+   PatternCatalog catalog(scratch);
+   DictionaryRegistry registry;
+   const PatternCatalog::Entry *aa = catalog.find("aa"),
+      *bb = catalog.find("bb");
+   check(aa && bb, "patterns not found in the catalog");
+   if (!aa || !bb)
+      return 1;
+
+   const HyphenationTree *tree;
+   check(request_concurrently(registry, *aa, tree) == 8,
+      "a failed load was not reported to every thread");
+   check(registry.size() == 0, "a failed load stays in the registry");
+
+   unlink((scratch + "/aa.profile").c_str());
+   check(request_concurrently(registry, *aa, tree) == 0 && tree,
+      "the load was not tried again");
+   check(registry.size() == 1, "registry size after loading aa");
+
+   /* bb has the same patterns as aa. */
+   check(&registry.tree(*bb) == tree, "equal patterns are not shared");
+   check(registry.size() == 1, "registry size after loading bb");
+   return failures != 0;
+}
@@ -0,0 +1,232 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+/* Tests of the ResultCache: words round-trip through the file, several
+ * processes writing to one small cache at once get the same results as
+ * without it and never read each other's torn slots, slots left locked
+ * by a dead writer are recovered, and a damaged header is refused. */
+
+#include "Hyphenator.h"
+#include "HyphenationRule.h"
+#include "ResultCache.h"
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace Hyphenate;
+
+/* Where ResultCache.cpp keeps the slot size and count, and the slots. */
+#define SLOT_SIZE_OFFSET 12
+#define SLOT_COUNT_OFFSET 16
+#define HEADER_SIZE 4096
+
+static int failures = 0;
+
+static void check(bool condition, const string &what) {
+   if (!condition) {
+      cout << what << endl;
+      failures++;
+   }
+}
+
+static void test_round_trip(const string &path) {
+   static const UniChar word[] = { 'h', 'y', 'p', 'h', 'e', 'n' };
+   UniChar long_word[ResultCache::max_word + 1];
+   UInt64 breaks;
+
+   for (CFIndex i = 0; i <= ResultCache::max_word; i++)
+      long_word[i] = 'a';
+   {
+      ResultCache cache(path.c_str(), 1024);
+      check(cache.size() == 1024, "cache size");
+      check(!cache.find(1, word, 6, breaks), "found in an empty cache");
+      cache.insert(1, word, 6, 0x4);
+      check(cache.find(1, word, 6, breaks) && breaks == 0x4,
+         "inserted word not found");
+      check(!cache.find(2, word, 6, breaks), "found for other patterns");
+      check(!cache.find(1, word, 5, breaks), "found a prefix");
+      cache.insert(1, long_word, ResultCache::max_word + 1, 0x4);
+      check(!cache.find(1, long_word, ResultCache::max_word + 1, breaks),
+         "found a word longer than max_word");
+   }
+   /* The file keeps its size and contents. */
+   ResultCache cache(path.c_str(), 16);
+   check(cache.size() == 1024, "reopened cache size");
+   check(cache.find(1, word, 6, breaks) && breaks == 0x4,
+      "word lost on reopening");
+}
+
+/* Hyphenates all words with and without the cache a few times and
+ * returns the number of differences. */
+static long compare_with_cache(Hyphenator &hyphenator, ResultCache &cache,
+      const vector<CFStringRef> &words, size_t first) {
+   long differences = 0;
+   for (size_t round = 0; round < 3 * words.size(); round++) {
+      CFStringRef word = words[(first + round) % words.size()];
+      hyphenator.setResultCache(NULL);
+      auto_ptr<vector<const HyphenationRule*> >
+         expected = hyphenator.applyHyphenationRules(word);
+      hyphenator.setResultCache(&cache);
+      auto_ptr<vector<const HyphenationRule*> >
+         got = hyphenator.applyHyphenationRules(word);
+      if (*expected != *got)
+         differences++;
+   }
+   return differences;
+}
+
+static void test_concurrent_writers(const string &patterns,
+      const string &path) {
+   vector<CFStringRef> words;
+   ifstream list("words");
+   string word;
+   while (getline(list, word)) {
+      CFStringRef s = CFStringCreateWithBytes(kCFAllocatorDefault,
+         (const UInt8 *)word.data(), word.size(), kCFStringEncodingUTF8,
+         false);
+      if (s)
+         words.push_back(s);
+   }
+
+   /* Far fewer slots than words, so that writers keep overwriting each
+    * other's slots. */
+   const int processes = 4;
+   { ResultCache create(path.c_str(), 256); }
+   for (int p = 0; p < processes; p++) {
+      pid_t child = fork();
+      if (child == 0) {
+         Hyphenator hyphenator((patterns + "/de").c_str());
+         ResultCache cache(path.c_str());
+         long differences = compare_with_cache(hyphenator, cache, words,
+            p * words.size() / processes);
+         _exit(differences != 0);
+      }
+      check(child > 0, "cannot fork");
+   }
+   int status;
+   while (wait(&status) > 0)
+      check(WIFEXITED(status) && WEXITSTATUS(status) == 0,
+         "a writer saw wrong results");
+
+   for (size_t i = 0; i < words.size(); i++)
+      CFRelease(words[i]);
+}
+
+/* Word i, for i below 676, is 40 letters long and differs from the
+ * others only in its last two letters, so that a reader is still
+ * comparing it while a writer replaces it; its breaks are derived
+ * from i. */
+static CFIndex make_word(unsigned i, UniChar *word, UInt64 &breaks) {
+   const CFIndex length = 40;
+   for (CFIndex j = 0; j < length - 2; j++)
+      word[j] = 'a' + j % 26;
+   word[length - 2] = 'a' + i / 26;
+   word[length - 1] = 'a' + i % 26;
+   breaks = (UInt64)i * 0x9e3779b97f4a7c15ULL;
+   return length;
+}
+
+static void test_torn_slots(const string &path) {
+   /* A handful of slots, so that processes write the same slots and read
+    * them while they are written. */
+   const int processes = 4;
+   { ResultCache create(path.c_str(), 8); }
+   for (int p = 0; p < processes; p++) {
+      pid_t child = fork();
+      if (child == 0) {
+         ResultCache cache(path.c_str());
+         UniChar word[40];
+         UInt64 breaks, found;
+         long wrong = 0;
+         for (unsigned i = 0; i < 400000; i++) {
+            unsigned n = (i * 7 + p * 13) % 676;
+            CFIndex length = make_word(n, word, breaks);
+            if (i % 2)
+               cache.insert(1, word, length, breaks);
+            else if (cache.find(1, word, length, found) && found != breaks)
+               wrong++;
+         }
+         _exit(wrong != 0);
+      }
+      check(child > 0, "cannot fork");
+   }
+   int status;
+   while (wait(&status) > 0)
+      check(WIFEXITED(status) && WEXITSTATUS(status) == 0,
+         "a reader saw a torn slot");
+}
+
+static void test_stuck_slots(const string &path) {
+   static const UniChar word[] = { 'w', 'o', 'r', 'd' };
+   UInt64 breaks;
+   { ResultCache cache(path.c_str(), 8); }
+
+   /* Leave every slot as a writer dying in the middle of a write would. */
+   int fd = open(path.c_str(), O_RDWR);
+   UInt32 slot_size = 0, sequence;
+   UInt64 slot_count = 0;
+   pread(fd, &slot_size, sizeof(slot_size), SLOT_SIZE_OFFSET);
+   pread(fd, &slot_count, sizeof(slot_count), SLOT_COUNT_OFFSET);
+   for (UInt64 i = 0; i < slot_count; i++) {
+      off_t offset = HEADER_SIZE + i * slot_size;
+      pread(fd, &sequence, sizeof(sequence), offset);
+      sequence = sequence * 2 + 1;
+      pwrite(fd, &sequence, sizeof(sequence), offset);
+   }
+   close(fd);
+
+   {
+      ResultCache cache(path.c_str());
+      cache.insert(1, word, 4, 0x2);
+      check(cache.find(1, word, 4, breaks) && breaks == 0x2,
+         "slots left locked by a dead writer");
+   }
+
+   /* A slot count that does not fit the address space. */
+   fd = open(path.c_str(), O_RDWR);
+   slot_count = (UInt64)-1 / 64;
+   pwrite(fd, &slot_count, sizeof(slot_count), SLOT_COUNT_OFFSET);
+   close(fd);
+   try {
+      ResultCache cache(path.c_str());
+      check(false, "damaged header accepted");
+   } catch (const domain_error &) {
+   }
+}
+
+int main(int argc, char **argv) {
+   if (argc < 3)
+      return 2;
+   string scratch = argv[2];
+
+   test_round_trip(scratch + "/round-trip.cache");
+   test_concurrent_writers(argv[1], scratch + "/concurrent.cache");
+   test_torn_slots(scratch + "/torn.cache");
+   test_stuck_slots(scratch + "/stuck.cache");
+   return failures != 0;
+}
@@ -0,0 +1,145 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+/* hyphenate-patgen: Generate a pattern file from a hyphenated word list.
+ *
+ * Usage: hyphenate-patgen [options] wordlist output
+ *   -s N       Safe area at the start of each word (default 2).
+ *   -e N       Safe area at the end of each word (default 2).
+ *   -j N       Number of counting threads (default: all processors).
+ *   -p FILE    Continue from the patterns in FILE.
+ *   -L L:S:F:G:B:T
+ *              Generate level L from patterns of S to F letters, with good
+ *              weight G, bad weight B and threshold T. May be given
+ *              repeatedly; levels must ascend. Without -L, four levels
+ *              with the usual patgen parameters are generated.
+ */
+
+#include "PatternGenerator.h"
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace Hyphenate;
+
+struct LevelParameters {
+   int level, start, finish, good, bad, threshold;
+};
+
+static void usage(const char *name) {
+   cerr << "Usage: " << name << " [-s start] [-e end] [-j threads] "
+      "[-p patterns] [-L level:start:finish:good:bad:threshold]... "
+      "wordlist output" << endl;
+   exit(2);
+}
+
+static void report(const char *what, const PatternGenerator &generator,
+   const PatternGenerator::Statistics &s)
+{
+   fprintf(stderr, "%s: %lu patterns, %lu good, %lu bad, %lu missed "
+      "(coverage %.2f%%, error rate %.2f%%)\n", what,
+      (unsigned long)generator.patternCount(), s.good, s.bad, s.missed,
+      s.coverage(), s.error_rate());
+}
+
+int main(int argc, char **argv) {
+   int start_safe = 2, end_safe = 2, threads = 0;
+   const char *patterns = NULL;
+   vector<LevelParameters> levels;
+
+   int opt;
+   while ((opt = getopt(argc, argv, "s:e:j:p:L:")) != -1) {
+      LevelParameters l;
+      switch (opt) {
+         case 's': start_safe = atoi(optarg); break;
+         case 'e': end_safe = atoi(optarg); break;
+         case 'j': threads = atoi(optarg); break;
+         case 'p': patterns = optarg; break;
+         case 'L':
+            if (sscanf(optarg, "%d:%d:%d:%d:%d:%d", &l.level, &l.start,
+                  &l.finish, &l.good, &l.bad, &l.threshold) != 6)
+               usage(argv[0]);
+            levels.push_back(l);
+            break;
+         default: usage(argv[0]);
+      }
+   }
+   if (argc - optind != 2)
+      usage(argv[0]);
+
+   if (levels.empty()) {
+      const LevelParameters defaults[] = {
+         { 1, 2, 5, 1, 1, 1 },
+         { 2, 2, 5, 1, 2, 1 },
+         { 3, 3, 6, 1, 1, 1 },
+         { 4, 3, 7, 1, 4, 1 }
+      };
+      levels.assign(defaults, defaults + 4);
+   }
+
+   try {
+      PatternGenerator generator(start_safe, end_safe);
+      if (threads)
+         generator.setThreads(threads);
+
+      ifstream words(argv[optind]);
+      if (!words) {
+         cerr << argv[0] << ": Cannot read " << argv[optind] << endl;
+         return 1;
+      }
+      generator.loadWordList(words);
+
+      if (patterns) {
+         ifstream p(patterns);
+         if (!p) {
+            cerr << argv[0] << ": Cannot read " << patterns << endl;
+            return 1;
+         }
+         generator.loadPatterns(p);
+      }
+      report("initial", generator, generator.evaluate());
+
+      for (vector<LevelParameters>::iterator l = levels.begin();
+            l != levels.end(); l++) {
+         char what[32];
+         snprintf(what, sizeof(what), "level %d", l->level);
+         report(what, generator, generator.generateLevel(l->level, l->start,
+            l->finish, l->good, l->bad, l->threshold));
+      }
+
+      ofstream output(argv[optind + 1]);
+      generator.writePatterns(output);
+      if (!output) {
+         cerr << argv[0] << ": Cannot write " << argv[optind + 1] << endl;
+         return 1;
+      }
+   } catch (const exception &e) {
+      cerr << argv[0] << ": " << e.what() << endl;
+      return 1;
+   }
+
+   return 0;
+}
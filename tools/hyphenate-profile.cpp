@@ -0,0 +1,109 @@
+/* libhyphenate-cfstring: A TeX-like hyphenation algorithm.
+ * Copyright (C) 2007 Steve Wolter
+ *   http://swolter.sdf1.org/
+ * Modifications Copyright (C) 2009 - 2010 Things Made Out Of Other Things Ltd.
+ *   http://th.ingsmadeoutofotherthin.gs/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ **/
+
+/* hyphenate-profile: Record which nodes of a pattern tree a corpus uses.
+ *
+ * Usage: hyphenate-profile [-o output] patterns corpus...
+ *   -o FILE    Write the profile to FILE instead of next to the patterns,
+ *              where Hyphenator picks it up to lay out the tree.
+ *
+ * An existing profile at the output is extended, so corpora can be added
+ * one after the other, unless it was made for other patterns, in which
+ * case it is replaced.
+ */
+
+#include "HyphenationTree.h"
+#include "NodeProfile.h"
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace Hyphenate;
+
+static void usage(const char *name) {
+   cerr << "Usage: " << name << " [-o output] patterns corpus..." << endl;
+   exit(2);
+}
+
+int main(int argc, char **argv) {
+   const char *output = NULL;
+
+   int opt;
+   while ((opt = getopt(argc, argv, "o:")) != -1) {
+      switch (opt) {
+         case 'o': output = optarg; break;
+         default: usage(argv[0]);
+      }
+   }
+   if (argc - optind < 2)
+      usage(argv[0]);
+   string patterns = argv[optind];
+   string profile_name = output ? output : NodeProfile::pathFor(patterns);
+
+   try {
+      HyphenationTree tree;
+      ifstream p(patterns.c_str());
+      if (!p) {
+         cerr << argv[0] << ": Cannot read " << patterns << endl;
+         return 1;
+      }
+      tree.loadPatterns(p);
+
+      NodeProfile profile;
+      ifstream existing(profile_name.c_str());
+      if (existing) {
+         profile.load(existing);
+         if (profile.patternChecksum() != tree.patternChecksum()) {
+            cerr << argv[0] << ": " << profile_name << " was made for "
+               "other patterns; starting over" << endl;
+            profile = NodeProfile();
+         }
+      }
+
+      for (int i = optind + 1; i < argc; i++) {
+         ifstream corpus(argv[i]);
+         if (!corpus) {
+            cerr << argv[0] << ": Cannot read " << argv[i] << endl;
+            return 1;
+         }
+         tree.profile(corpus, profile);
+      }
+
+      ofstream out(profile_name.c_str());
+      profile.save(out);
+      if (!out) {
+         cerr << argv[0] << ": Cannot write " << profile_name << endl;
+         return 1;
+      }
+      fprintf(stderr, "%s: %lu nodes visited\n", profile_name.c_str(),
+         (unsigned long)profile.size());
+   } catch (const exception &e) {
+      cerr << argv[0] << ": " << e.what() << endl;
+      return 1;
+   }
+
+   return 0;
+}